@@ -0,0 +1,44 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Kept out of the benchmark's own translation unit, where the compiler would inline these and then warn about free
+// being called on memory from operator new
+
+namespace {
+	std::atomic<uint64_t> g_Allocations{0};
+}// namespace
+
+uint64_t AllocationCount() {
+	return g_Allocations.load();
+}
+
+void* operator new(size_t size) {
+	g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	operator delete(pointer);
+}
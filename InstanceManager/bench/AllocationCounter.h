@@ -0,0 +1,6 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocations made through operator new so far, by any thread. AllocationCounter.cpp replaces the global
+// operators to count them.
+uint64_t AllocationCount();
@@ -0,0 +1,260 @@
+// Time and disk use of creating instances from the Template folder, hardlink clones and the packed template image
+// against the full copy they replaced, and the wall time and peak working set of extracting Windows10Universal.zip. Results are written as JSON
+// the same way Scanner_Bench writes them.
+//
+//   Provisioning_Bench [--quick] [--template Template] [--scratch bench-scratch] [--out results.json]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+
+#include "appx/TemplateImage.h"
+#include "libzippp/libzippp.h"
+#include "utils/filesystem/FS.h"
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// The same files InstanceControl keeps private in hardlink mode
+	const std::vector<std::filesystem::path> PRIVATE_FILES = {
+	        "AppxManifest.xml",
+	        "Windows10Universal.exe",
+	        std::filesystem::path("Assets") / "CrashHandler.exe",
+	};
+
+	// Extraction before it streamed, the whole entry was inflated into a string before any of it was written
+	namespace Reference {
+		bool DecompressZipToFile(const std::string& zipPath, const std::string& destination) {
+			libzippp::ZipArchive zip(zipPath);
+			if (!zip.open(libzippp::ZipArchive::ReadOnly) || zip.getNbEntries() != 1) {
+				return false;
+			}
+
+			std::string content = zip.getEntry(0).readAsText();
+			std::ofstream outputFile(destination, std::ios::binary);
+			outputFile.write(content.c_str(), static_cast<std::streamsize>(content.size()));
+			zip.close();
+			return static_cast<bool>(outputFile);
+		}
+	}// namespace Reference
+
+	struct Result {
+		std::string Name;
+		std::string Variant;
+		size_t Instances = 0;
+		double Seconds = 0;
+		uint64_t BytesWritten = 0;// data that is not shared with the template through a hardlink
+		uint64_t PeakWorkingSet = 0;// extraction only
+	};
+
+	struct Options {
+		bool Quick = false;
+		std::filesystem::path TemplateDir = "Template";
+		std::filesystem::path ScratchDir = "bench-scratch";
+		std::string OutputPath;
+	};
+
+	// Bytes under dir that belong to files with no other link
+	uint64_t PrivateBytes(const std::filesystem::path& dir) {
+		uint64_t bytes = 0;
+		for (const auto& entry: std::filesystem::recursive_directory_iterator(dir)) {
+			if (entry.is_regular_file() && entry.hard_link_count() == 1) {
+				bytes += entry.file_size();
+			}
+		}
+		return bytes;
+	}
+
+	// Best time of a few runs, each creating the instances into an empty scratch folder. Bytes are from the last run.
+	Result Measure(const Options& options, std::string name, std::string variant, size_t instances,
+	               const std::function<bool(const std::filesystem::path&)>& create) {
+		Result result{std::move(name), std::move(variant), instances, 1e300, 0, 0};
+
+		for (int trial = 0; trial < (options.Quick ? 1 : 3); ++trial) {
+			std::filesystem::remove_all(options.ScratchDir);
+			std::filesystem::create_directories(options.ScratchDir);
+
+			const auto start = Clock::now();
+			for (size_t i = 0; i < instances; ++i) {
+				if (!create(options.ScratchDir / fmt::format("instance{}", i))) {
+					std::cerr << "Failed to create " << result.Variant << " instance " << i << "\n";
+				}
+			}
+			result.Seconds = std::min(result.Seconds, std::chrono::duration<double>(Clock::now() - start).count());
+
+			result.BytesWritten = 0;
+			for (size_t i = 0; i < instances; ++i) {
+				result.BytesWritten += PrivateBytes(options.ScratchDir / fmt::format("instance{}", i));
+			}
+		}
+
+		std::filesystem::remove_all(options.ScratchDir);
+		return result;
+	}
+
+	void BenchCreateInstances(const Options& options, std::vector<Result>& results) {
+		// Packing is part of updating the template, not of creating an instance, so it happens outside the timing
+		auto imagePath = options.ScratchDir;
+		imagePath += ".pack";
+		std::unique_ptr<Appx::TemplateImage> image;
+		if (Appx::TemplateImage::Build(options.TemplateDir, imagePath)) {
+			image = Appx::TemplateImage::Open(imagePath);
+		}
+
+		for (size_t instances: {size_t{1}, size_t{4}}) {
+			if (options.Quick && instances > 1) {
+				break;
+			}
+
+			results.push_back(Measure(options, "create_instances", "copy", instances, [&](const std::filesystem::path& dst) {
+				return FS::CopyDirectory(options.TemplateDir, dst);
+			}));
+			results.push_back(Measure(options, "create_instances", "hardlink", instances, [&](const std::filesystem::path& dst) {
+				return FS::CloneDirectory(options.TemplateDir, dst, PRIVATE_FILES);
+			}));
+
+			if (image) {
+				results.push_back(Measure(options, "create_instances", "image", instances, [&](const std::filesystem::path& dst) {
+					return image->Materialize(dst);
+				}));
+			}
+		}
+
+		image.reset();
+		std::filesystem::remove(imagePath);
+	}
+
+	uint64_t WorkingSet() {
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.WorkingSetSize;
+	}
+
+	// The process-wide peak can't be reset between variants, so the working set is sampled while fn runs instead
+	std::pair<bool, uint64_t> SamplePeakWorkingSet(const std::function<bool()>& fn) {
+		std::atomic<bool> done{false};
+		std::atomic<uint64_t> peak{WorkingSet()};
+
+		std::thread sampler([&]() {
+			while (!done.load()) {
+				peak.store(std::max(peak.load(), WorkingSet()));
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+
+		const bool success = fn();
+		done.store(true);
+		sampler.join();
+
+		return {success, std::max(peak.load(), WorkingSet())};
+	}
+
+	void BenchExtract(const Options& options, std::vector<Result>& results) {
+		const std::filesystem::path zip = options.TemplateDir / "Windows10Universal.zip";
+		if (!std::filesystem::exists(zip)) {
+			std::cerr << "No " << zip.string() << ", skipping the extraction benchmark\n";
+			return;
+		}
+
+		std::filesystem::create_directories(options.ScratchDir);
+		const std::filesystem::path destination = options.ScratchDir / "Windows10Universal.exe";
+
+		auto measure = [&](std::string variant, const std::function<bool(const std::string&, const std::string&)>& extract) {
+			Result result{"extract_zip", std::move(variant), 1, 1e300, 0, 0};
+
+			for (int trial = 0; trial < (options.Quick ? 1 : 3); ++trial) {
+				std::filesystem::remove(destination);
+
+				const auto start = Clock::now();
+				auto [success, peak] = SamplePeakWorkingSet([&]() { return extract(zip.string(), destination.string()); });
+				result.Seconds = std::min(result.Seconds, std::chrono::duration<double>(Clock::now() - start).count());
+				result.PeakWorkingSet = std::max(result.PeakWorkingSet, peak);
+
+				if (!success) {
+					std::cerr << "Failed to extract " << zip.string() << " (" << result.Variant << ")\n";
+				}
+			}
+
+			result.BytesWritten = std::filesystem::file_size(destination);
+			results.push_back(std::move(result));
+		};
+
+		// Streaming goes first, memory the whole entry variant frees may not leave the working set right away
+		measure("streaming", FS::DecompressZipToFile);
+		measure("whole_entry", Reference::DecompressZipToFile);
+
+		std::filesystem::remove_all(options.ScratchDir);
+	}
+
+	std::string ToJson(const std::vector<Result>& results) {
+		std::string json = "{\n  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			json += fmt::format("    {{\"name\": \"{}\", \"variant\": \"{}\", \"instances\": {}, \"seconds\": {:.6f}, \"bytes_written\": {}, \"peak_working_set\": {}}}{}\n",
+			                    r.Name, r.Variant, r.Instances, r.Seconds, r.BytesWritten, r.PeakWorkingSet, i + 1 < results.size() ? "," : "");
+		}
+		json += "  ]\n}\n";
+		return json;
+	}
+}// namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--quick") {
+			options.Quick = true;
+		} else if (arg == "--template" && i + 1 < argc) {
+			options.TemplateDir = argv[++i];
+		} else if (arg == "--scratch" && i + 1 < argc) {
+			options.ScratchDir = argv[++i];
+		} else if (arg == "--out" && i + 1 < argc) {
+			options.OutputPath = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--template Template] [--scratch bench-scratch] [--out results.json]\n";
+			return 1;
+		}
+	}
+
+	if (!std::filesystem::is_directory(options.TemplateDir)) {
+		std::cerr << options.TemplateDir.string() << " is not a directory\n";
+		return 1;
+	}
+
+	std::vector<Result> results;
+	BenchCreateInstances(options, results);
+	BenchExtract(options, results);
+
+	for (const Result& r: results) {
+		std::cerr << fmt::format("{:<18} {:<12} {:>2} instances  {:>10.3f} ms  {:>8.1f} MB written  {:>8.1f} MB peak working set\n", r.Name, r.Variant,
+		                         r.Instances, r.Seconds * 1e3, static_cast<double>(r.BytesWritten) / 1e6, static_cast<double>(r.PeakWorkingSet) / 1e6);
+	}
+
+	const std::string json = ToJson(results);
+	if (options.OutputPath.empty()) {
+		std::cout << json;
+	} else {
+		std::ofstream out(options.OutputPath);
+		out << json;
+		if (!out) {
+			std::cerr << "Failed to write " << options.OutputPath << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
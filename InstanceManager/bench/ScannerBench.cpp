@@ -0,0 +1,451 @@
+// Throughput of the memory scanner's kernels on synthetic buffers, and of whole searches against this process.
+// Results are written as JSON so a regression run can compare them with an earlier one.
+//
+//   Scanner_Bench [--quick] [--out results.json]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "scanner/FixedPattern.h"
+#include "scanner/IncrementalScan.h"
+#include "scanner/MemorySearch.h"
+#include "scanner/Pattern.h"
+#include "scanner/PatternSet.h"
+#include "scanner/RegionCache.h"
+#include "utils/cpu/CpuFeatures.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	constexpr std::string_view ROBLOX_SIGNATURE = "6B 65 79 3D ?? ?? ?? ?? ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 26 63 6F 64 65 3D";
+	constexpr std::string_view ROBLOX_MATCH = "key=01234567-89ab-cdef-0123-456789abcdef&code=";
+
+	// The scanner before the pattern kernels replaced it, kept as the baseline the new numbers are read against
+	namespace Reference {
+		std::vector<unsigned char> ParsePattern(const std::string& patternString) {
+			std::vector<unsigned char> pattern;
+			size_t start = 0;
+			size_t end = patternString.find(' ');
+
+			while (end != std::string::npos) {
+				std::string byteString = patternString.substr(start, end - start);
+				if (byteString == "??") {
+					pattern.push_back('?');
+				} else {
+					pattern.push_back(static_cast<unsigned char>(std::strtol(byteString.c_str(), nullptr, 16)));
+				}
+				start = end + 1;
+				end = patternString.find(' ', start);
+			}
+
+			std::string byteString = patternString.substr(start, end);
+			if (byteString == "??") {
+				pattern.push_back('?');
+			} else {
+				pattern.push_back(static_cast<unsigned char>(std::strtol(byteString.c_str(), nullptr, 16)));
+			}
+
+			return pattern;
+		}
+
+		// 0 means not found, a match at the very start of the data is lost with it
+		uintptr_t BoyerMooreHorspool(const unsigned char* signature, size_t signatureSize, const unsigned char* data, size_t dataSize) {
+			size_t maxShift = signatureSize;
+			size_t maxIndex = signatureSize - 1;
+			size_t wildCardIndex = 0;
+			for (size_t i = 0; i < maxIndex; i++) {
+				if (signature[i] == '?') {
+					maxShift = maxIndex - i;
+					wildCardIndex = i;
+				}
+			}
+
+			size_t shiftTable[256];
+			for (size_t i = 0; i <= 255; i++) {
+				shiftTable[i] = maxShift;
+			}
+
+			for (size_t i = wildCardIndex + 1; i < maxIndex - 1; i++) {
+				shiftTable[signature[i]] = maxIndex - i;
+			}
+
+			for (size_t currentIndex = 0; currentIndex < dataSize - signatureSize;) {
+				for (size_t sigIndex = maxIndex;; sigIndex--) {
+					if (data[currentIndex + sigIndex] != signature[sigIndex] && signature[sigIndex] != '?') {
+						currentIndex += shiftTable[data[currentIndex + maxIndex]];
+						break;
+					} else if (sigIndex == 0) {
+						return currentIndex;
+					}
+				}
+			}
+
+			return 0;
+		}
+	}// namespace Reference
+
+	struct Result {
+		std::string Name;
+		std::string Variant;
+		uint64_t Bytes = 0;
+		size_t MatchEvery = 0;// 0 for a buffer without planted matches
+		int WildcardPercent = 0;
+		size_t Alignment = 0;
+		size_t Matches = 0;
+		double Seconds = 0;
+	};
+
+	struct Options {
+		bool Quick = false;
+		std::string OutputPath;
+	};
+
+	// Best time of a few trials, each repeating fn until it has run long enough to time reliably
+	template<typename Function>
+	double Measure(const Options& options, Function&& fn) {
+		const auto minimum = options.Quick ? std::chrono::milliseconds(20) : std::chrono::milliseconds(150);
+		const int trials = options.Quick ? 3 : 5;
+
+		fn();
+
+		double best = 1e300;
+		for (int trial = 0; trial < trials; ++trial) {
+			size_t iterations = 0;
+			const auto start = Clock::now();
+			auto elapsed = Clock::duration::zero();
+			do {
+				fn();
+				++iterations;
+				elapsed = Clock::now() - start;
+			} while (elapsed < minimum);
+
+			best = std::min(best, std::chrono::duration<double>(elapsed).count() / static_cast<double>(iterations));
+		}
+		return best;
+	}
+
+	// Looks like process memory: zero filled stretches, text and random binary data in 64 byte blocks
+	std::vector<uint8_t> SyntheticMemory(size_t size, uint32_t seed) {
+		std::mt19937 random(seed);
+		std::vector<uint8_t> data(size);
+
+		for (size_t block = 0; block < size; block += 64) {
+			const size_t end = std::min(size, block + 64);
+			const uint32_t kind = random() % 10;
+			for (size_t i = block; i < end; ++i) {
+				if (kind < 4) {
+					data[i] = 0;
+				} else if (kind < 7) {
+					data[i] = static_cast<uint8_t>("etaoin shrdlu,.\"{}:"[random() % 19]);
+				} else {
+					data[i] = static_cast<uint8_t>(random());
+				}
+			}
+		}
+
+		return data;
+	}
+
+	void Plant(std::vector<uint8_t>& data, std::string_view match, size_t every) {
+		if (every == 0) {
+			return;
+		}
+		for (size_t offset = every / 2; offset + match.size() <= data.size(); offset += every) {
+			std::memcpy(data.data() + offset, match.data(), match.size());
+		}
+	}
+
+	// A 16 byte signature of mostly text bytes, with every n-th byte a wildcard
+	std::string MakeSignature(int wildcardPercent) {
+		const std::string_view bytes = "\"session\":\"tok=";
+		const int wildcardEvery = wildcardPercent == 0 ? 0 : 100 / wildcardPercent;
+
+		std::string signature;
+		for (size_t i = 0; i < bytes.size(); ++i) {
+			if (!signature.empty()) {
+				signature += ' ';
+			}
+			// The first byte stays fixed, so every kernel has an anchor
+			signature += wildcardEvery != 0 && i % wildcardEvery == static_cast<size_t>(wildcardEvery - 1) ? "??" : fmt::format("{:02X}", static_cast<uint8_t>(bytes[i]));
+		}
+		return signature;
+	}
+
+	constexpr std::string_view SIGNATURE_MATCH = "\"session\":\"tok=";
+
+	size_t FindAll(const Scanner::Pattern& pattern, std::span<const uint8_t> data, Scanner::Pattern::Kernel kernel) {
+		size_t matches = 0;
+		size_t position = 0;
+		while (auto offset = pattern.Find(data.subspan(position), kernel)) {
+			++matches;
+			position += *offset + 1;
+		}
+		return matches;
+	}
+
+	size_t FindAllReference(const std::vector<unsigned char>& signature, std::span<const uint8_t> data) {
+		size_t matches = 0;
+		size_t position = 0;
+		while (position + signature.size() < data.size()) {
+			uintptr_t offset = Reference::BoyerMooreHorspool(signature.data(), signature.size(), data.data() + position, data.size() - position);
+			if (offset == 0) {
+				break;
+			}
+			++matches;
+			position += offset + 1;
+		}
+		return matches;
+	}
+
+	struct Case {
+		size_t Size;
+		size_t MatchEvery;
+		int WildcardPercent;
+		size_t Alignment;
+	};
+
+	void BenchKernels(const Options& options, std::vector<Result>& results) {
+		const size_t base = options.Quick ? (1 << 20) : (16 << 20);
+
+		// One dimension is varied at a time around the base case
+		std::vector<Case> cases;
+		for (size_t size: {size_t{4} << 10, size_t{64} << 10, size_t{1} << 20, size_t{16} << 20, size_t{64} << 20}) {
+			if (!options.Quick || size <= base) {
+				cases.push_back({size, 0, 0, 0});
+			}
+		}
+		for (size_t every: {size_t{1} << 20, size_t{4} << 10, size_t{256}}) {
+			cases.push_back({base, every, 0, 0});
+		}
+		for (int wildcards: {25, 50}) {
+			cases.push_back({base, 0, wildcards, 0});
+		}
+		for (size_t alignment: {1, 13}) {
+			cases.push_back({base, 0, 0, alignment});
+		}
+
+		const CpuFeatures& cpu = CpuFeatures::Get();
+		std::vector<std::pair<std::string, Scanner::Pattern::Kernel>> kernels = {{"scalar", Scanner::Pattern::Kernel::Scalar}};
+		if (cpu.Sse2) {
+			kernels.emplace_back("sse2", Scanner::Pattern::Kernel::Sse2);
+		}
+		if (cpu.Avx2) {
+			kernels.emplace_back("avx2", Scanner::Pattern::Kernel::Avx2);
+		}
+
+		for (const Case& c: cases) {
+			std::vector<uint8_t> storage = SyntheticMemory(c.Size + c.Alignment, 1234);
+			Plant(storage, SIGNATURE_MATCH, c.MatchEvery);
+			std::span<const uint8_t> data(storage.data() + c.Alignment, c.Size);
+
+			const std::string signature = MakeSignature(c.WildcardPercent);
+			const Scanner::Pattern pattern = *Scanner::Pattern::Parse(signature);
+
+			auto record = [&](std::string variant, size_t matches, double seconds) {
+				results.push_back({"pattern_find", std::move(variant), c.Size, c.MatchEvery, c.WildcardPercent, c.Alignment, matches, seconds});
+			};
+
+			const std::vector<unsigned char> reference = Reference::ParsePattern(signature);
+			// Measured before record is called, an argument list is evaluated in no particular order
+			size_t matches = 0;
+			double seconds = Measure(options, [&]() { matches = FindAllReference(reference, data); });
+			record("bmh_reference", matches, seconds);
+
+			for (const auto& [name, kernel]: kernels) {
+				seconds = Measure(options, [&]() { matches = FindAll(pattern, data, kernel); });
+				record(name, matches, seconds);
+			}
+		}
+	}
+
+	void BenchPatternSet(const Options& options, std::vector<Result>& results) {
+		using namespace Scanner::Literals;
+
+		Scanner::PatternSet set;
+		set.Add(*Scanner::Pattern::Parse(ROBLOX_SIGNATURE));
+		set.Add("22 63 6F 64 65 22 3A 22"_pattern);
+
+		const size_t size = options.Quick ? (1 << 20) : (16 << 20);
+		for (size_t every: {size_t{0}, size_t{1} << 20, size_t{4} << 10}) {
+			std::vector<uint8_t> data = SyntheticMemory(size, 99);
+			Plant(data, ROBLOX_MATCH, every);
+
+			size_t matches = 0;
+			const double seconds = Measure(options, [&]() {
+				matches = 0;
+				set.Scan(data, [&](const Scanner::PatternMatch&) {
+					++matches;
+					return true;
+				});
+			});
+			results.push_back({"pattern_set", "roblox_rules", size, every, 0, 0, matches, seconds});
+		}
+	}
+
+	void BenchParse(const Options& options, std::vector<Result>& results) {
+		const std::string signature(ROBLOX_SIGNATURE);
+
+		size_t size = 0;
+		results.push_back({"parse", "reference", 0, 0, 0, 0, 0, Measure(options, [&]() { size += Reference::ParsePattern(signature).size(); })});
+		results.push_back({"parse", "pattern_parse", 0, 0, 0, 0, 0, Measure(options, [&]() { size += Scanner::Pattern::Parse(signature)->Size(); })});
+
+		// What is left at run time of a _pattern literal is the copy into a Pattern
+		using namespace Scanner::Literals;
+		static constexpr auto literal = "6B 65 79 3D ?? ?? ?? ?? ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 26 63 6F 64 65 3D"_pattern;
+		results.push_back({"parse", "fixed_pattern", 0, 0, 0, 0, 0, Measure(options, [&]() { size += Scanner::Pattern(literal).Size(); })});
+
+		if (size == 0) {
+			std::abort();
+		}
+	}
+
+	uint32_t CurrentPid() {
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return static_cast<uint32_t>(getpid());
+#endif
+	}
+
+	std::string ExtractValue(const unsigned char* data, size_t size) {
+		const unsigned char* end = std::find(data, data + size, '"');
+		return std::string(data, end);
+	}
+
+	// Whole searches through the process memory backend, against this process with a large heap buffer in it
+	void BenchLiveProcess(const Options& options, std::vector<Result>& results) {
+		const size_t size = options.Quick ? (64 << 20) : (256 << 20);
+		std::vector<uint8_t> heap = SyntheticMemory(size, 7);
+
+		const std::string planted = std::string(ROBLOX_MATCH) + "BENCHCODE\"";
+		std::memcpy(heap.data() + size / 4 * 3, planted.data(), planted.size());
+
+		auto memory = Scanner::ProcessMemory::Open(CurrentPid());
+		if (!memory) {
+			std::cerr << "Cannot open this process's memory, skipping the live benchmarks\n";
+			return;
+		}
+
+		uint64_t readable = 0;
+		for (const auto& region: Scanner::RegionCache::Prioritize(memory->Regions())) {
+			readable += region.Size;
+		}
+
+		const std::vector<Scanner::SearchRule> rules = {
+		        {*Scanner::Pattern::Parse(ROBLOX_SIGNATURE), ExtractValue},
+		        {*Scanner::Pattern::Parse("22 63 6F 64 65 22 3A 22"), ExtractValue},
+		};
+
+		// bytes is what was actually scanned, so gb_per_s is left at zero for the searches, which stop at their
+		// first match wherever it happens to be
+		auto record = [&](std::string variant, uint64_t bytes, size_t matches, double seconds) {
+			results.push_back({"live_process", std::move(variant), bytes, 0, 0, 0, matches, seconds});
+		};
+
+		size_t found = 0;
+		double seconds = Measure(options, [&]() {
+			Scanner::RegionCache::GetInstance().Invalidate(*memory);
+			found = Scanner::SearchMemory(*memory, rules).empty() ? 0 : 1;
+		});
+		record("search_memory_cold", 0, found, seconds);
+
+		seconds = Measure(options, [&]() { found = Scanner::SearchMemory(*memory, rules).empty() ? 0 : 1; });
+		record("search_memory_cached", 0, found, seconds);
+
+		const std::vector<Scanner::Pattern> patterns = {rules[0].Signature, rules[1].Signature};
+		seconds = Measure(options, [&]() {
+			found = 0;
+			Scanner::ScanMemory(*memory, patterns, [&](const Scanner::MemoryMatch&) {
+				++found;
+				return true;
+			});
+		});
+		record("scan_memory_all", readable, found, seconds);
+
+		Scanner::IncrementalScan incremental(*memory, patterns);
+		const auto start = Clock::now();
+		incremental.Next([](const Scanner::MemoryMatch&) { return true; });
+		record("incremental_first_pass", incremental.LastScannedBytes(), 0, std::chrono::duration<double>(Clock::now() - start).count());
+
+		seconds = Measure(options, [&]() { incremental.Next([](const Scanner::MemoryMatch&) { return true; }); });
+		record("incremental_idle_pass", incremental.LastScannedBytes(), 0, seconds);
+	}
+
+	std::string ToJson(const std::vector<Result>& results) {
+		const CpuFeatures& cpu = CpuFeatures::Get();
+
+		std::string json = fmt::format("{{\n  \"cpu\": {{\"sse2\": {}, \"ssse3\": {}, \"sse41\": {}, \"avx2\": {}, \"sha\": {}}},\n  \"threads\": {},\n  \"results\": [\n",
+		                               cpu.Sse2, cpu.Ssse3, cpu.Sse41, cpu.Avx2, cpu.Sha, std::thread::hardware_concurrency());
+
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			const double gigabytesPerSecond = r.Bytes == 0 ? 0.0 : static_cast<double>(r.Bytes) / r.Seconds / 1e9;
+			json += fmt::format("    {{\"name\": \"{}\", \"variant\": \"{}\", \"bytes\": {}, \"match_every\": {}, \"wildcard_percent\": {}, \"alignment\": {}, "
+			                    "\"matches\": {}, \"seconds\": {:.9f}, \"gb_per_s\": {:.3f}, \"ops_per_s\": {:.1f}}}{}\n",
+			                    r.Name, r.Variant, r.Bytes, r.MatchEvery, r.WildcardPercent, r.Alignment, r.Matches, r.Seconds, gigabytesPerSecond,
+			                    1.0 / r.Seconds, i + 1 < results.size() ? "," : "");
+		}
+
+		json += "  ]\n}\n";
+		return json;
+	}
+}// namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--quick") {
+			options.Quick = true;
+		} else if (arg == "--out" && i + 1 < argc) {
+			options.OutputPath = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--out results.json]\n";
+			return 1;
+		}
+	}
+
+	std::vector<Result> results;
+	BenchParse(options, results);
+	BenchKernels(options, results);
+	BenchPatternSet(options, results);
+	BenchLiveProcess(options, results);
+
+	for (const Result& r: results) {
+		std::cerr << fmt::format("{:<14} {:<24} {:>10} B  every {:>8}  wild {:>2}%  align {:>2}  {:>10.3f} us  {:>8.2f} GB/s\n", r.Name, r.Variant, r.Bytes, r.MatchEvery,
+		                         r.WildcardPercent, r.Alignment, r.Seconds * 1e6, r.Bytes == 0 ? 0.0 : static_cast<double>(r.Bytes) / r.Seconds / 1e9);
+	}
+
+	const std::string json = ToJson(results);
+	if (options.OutputPath.empty()) {
+		std::cout << json;
+	} else {
+		std::ofstream out(options.OutputPath);
+		out << json;
+		if (!out) {
+			std::cerr << "Failed to write " << options.OutputPath << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
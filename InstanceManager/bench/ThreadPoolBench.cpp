@@ -0,0 +1,300 @@
+// Contention in ThreadPool against the single-queue pool it replaced, at 1 to 64 workers, along with the heap
+// allocations every task costs. Results are written as JSON the same way Scanner_Bench writes them.
+//
+//   ThreadPool_Bench [--quick] [--out results.json]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "AllocationCounter.h"
+#include "utils/threadpool/ThreadPool.hpp"
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// The pool before work stealing: one queue, one mutex, one condition variable, a heap-allocated task holder
+	namespace Reference {
+		class TaskWrapper {
+			struct ITask {
+				virtual ~ITask() = default;
+				virtual void execute() = 0;
+			};
+
+			template<typename Func>
+			struct TaskHolder : ITask {
+				explicit TaskHolder(Func&& func) : func_(std::move(func)) {}
+				void execute() override { func_(); }
+				Func func_;
+			};
+
+			std::unique_ptr<ITask> task_;
+
+		public:
+			template<class Func>
+			explicit TaskWrapper(Func&& func) {
+				task_ = std::make_unique<TaskHolder<Func>>(std::move(func));
+			}
+
+			void operator()() {
+				task_->execute();
+			}
+		};
+
+		class ThreadPool {
+		public:
+			explicit ThreadPool(size_t num_threads) {
+				for (size_t i = 0; i < num_threads; ++i) {
+					workers.emplace_back([this] {
+						while (true) {
+							std::optional<TaskWrapper> task_opt;
+							{
+								std::unique_lock<std::mutex> lock(queue_mutex);
+								condition.wait(lock, [this] { return stop || !tasks.empty(); });
+								if (stop && tasks.empty()) return;
+								task_opt = std::move(tasks.front());
+								tasks.pop();
+							}
+							(*task_opt)();
+						}
+					});
+				}
+			}
+
+			~ThreadPool() {
+				{
+					std::scoped_lock<std::mutex> lock(queue_mutex);
+					stop = true;
+				}
+				condition.notify_all();
+				for (std::thread& worker: workers) {
+					worker.join();
+				}
+			}
+
+			template<class F>
+			auto SubmitTask(F&& f) -> std::future<std::invoke_result_t<F>> {
+				std::packaged_task<std::invoke_result_t<F>()> packaged(std::forward<F>(f));
+				auto result = packaged.get_future();
+				{
+					std::scoped_lock<std::mutex> lock(queue_mutex);
+					tasks.emplace(std::move(packaged));
+				}
+				condition.notify_one();
+				return result;
+			}
+
+			// Had no fire and forget, the future was just dropped
+			template<class F>
+			void Post(F&& f) {
+				SubmitTask(std::forward<F>(f));
+			}
+
+		private:
+			std::vector<std::thread> workers;
+			std::queue<TaskWrapper> tasks;
+			std::mutex queue_mutex;
+			std::condition_variable condition;
+			bool stop = false;
+		};
+	}// namespace Reference
+
+	struct Result {
+		std::string Name;
+		std::string Pool;
+		size_t Threads = 0;
+		size_t Tasks = 0;
+		double Seconds = 0;
+		double AllocationsPerTask = 0;
+	};
+
+	struct Options {
+		bool Quick = false;
+		std::string OutputPath;
+	};
+
+	// Best time of a few runs. The allocations are those of the last run, after the earlier ones warmed the pool up.
+	template<typename Function>
+	std::pair<double, uint64_t> Measure(const Options& options, Function&& fn) {
+		double best = 1e300;
+		uint64_t allocations = 0;
+		for (int trial = 0; trial < (options.Quick ? 2 : 5); ++trial) {
+			const uint64_t allocationsBefore = AllocationCount();
+			const auto start = Clock::now();
+			fn();
+			best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+			allocations = AllocationCount() - allocationsBefore;
+		}
+		return {best, allocations};
+	}
+
+	// Counts tasks down and wakes the waiting thread when the last one is done
+	class Countdown {
+	public:
+		explicit Countdown(size_t count) : m_Remaining(count) {}
+
+		void Done() {
+			if (m_Remaining.fetch_sub(1) == 1) {
+				std::scoped_lock lock(m_Mutex);
+				m_Finished = true;
+				m_Condition.notify_all();
+			}
+		}
+
+		void Wait() {
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return m_Finished; });
+		}
+
+	private:
+		std::atomic<size_t> m_Remaining;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Finished = false;
+	};
+
+	// One thread outside the pool submits every task, then waits on all the futures
+	template<typename Pool>
+	void SubmitFromOutside(Pool& pool, std::vector<std::future<void>>& futures, size_t tasks) {
+		for (size_t i = 0; i < tasks; ++i) {
+			futures.push_back(pool.SubmitTask([]() {}));
+		}
+		for (auto& future: futures) {
+			future.get();
+		}
+	}
+
+	// The same without futures
+	template<typename Pool>
+	void PostFromOutside(Pool& pool, size_t tasks) {
+		Countdown countdown(tasks);
+		for (size_t i = 0; i < tasks; ++i) {
+			pool.Post([&countdown]() { countdown.Done(); });
+		}
+		countdown.Wait();
+	}
+
+	// As many threads outside the pool as it has workers, all submitting at once
+	template<typename Pool>
+	void ManySubmitters(Pool& pool, size_t threads, size_t tasks) {
+		Countdown countdown(tasks);
+		std::vector<std::thread> submitters;
+		for (size_t t = 0; t < threads; ++t) {
+			submitters.emplace_back([&, t]() {
+				for (size_t i = t; i < tasks; i += threads) {
+					pool.Post([&countdown]() { countdown.Done(); });
+				}
+			});
+		}
+		for (auto& submitter: submitters) {
+			submitter.join();
+		}
+		countdown.Wait();
+	}
+
+	// Tasks that split into two more until the tree is deep enough, everything after the root is submitted by workers
+	template<typename Pool>
+	void Spawn(Pool& pool, Countdown& countdown, int depth) {
+		if (depth == 0) {
+			countdown.Done();
+			return;
+		}
+		pool.Post([&pool, &countdown, depth]() { Spawn(pool, countdown, depth - 1); });
+		pool.Post([&pool, &countdown, depth]() { Spawn(pool, countdown, depth - 1); });
+	}
+
+	template<typename Pool>
+	void NestedFanOut(Pool& pool, int depth) {
+		Countdown countdown(size_t{1} << depth);
+		pool.Post([&pool, &countdown, depth]() { Spawn(pool, countdown, depth); });
+		countdown.Wait();
+	}
+
+	template<typename Pool>
+	void BenchPool(const Options& options, const std::string& name, size_t threads, std::vector<Result>& results) {
+		Pool pool(threads);
+
+		const size_t tasks = options.Quick ? 20000 : 200000;
+		const int depth = options.Quick ? 14 : 17;
+
+		auto record = [&](std::string benchmark, size_t count, std::pair<double, uint64_t> measured) {
+			results.push_back({std::move(benchmark), name, threads, count, measured.first, static_cast<double>(measured.second) / static_cast<double>(count)});
+		};
+
+		// The futures' own vector is reserved up front, so it doesn't count towards the tasks' allocations
+		std::vector<std::future<void>> futures;
+		futures.reserve(tasks);
+		record("submit_from_outside", tasks, Measure(options, [&]() { futures.clear(); SubmitFromOutside(pool, futures, tasks); }));
+		record("post_from_outside", tasks, Measure(options, [&]() { PostFromOutside(pool, tasks); }));
+		record("many_submitters", tasks, Measure(options, [&]() { ManySubmitters(pool, threads, tasks); }));
+		// Every inner node submits two tasks, so about twice the leaves
+		record("nested_fan_out", (size_t{2} << depth) - 1, Measure(options, [&]() { NestedFanOut(pool, depth); }));
+	}
+
+	std::string ToJson(const std::vector<Result>& results) {
+		std::string json = fmt::format("{{\n  \"hardware_threads\": {},\n  \"results\": [\n", std::thread::hardware_concurrency());
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			json += fmt::format("    {{\"name\": \"{}\", \"pool\": \"{}\", \"threads\": {}, \"tasks\": {}, \"seconds\": {:.9f}, \"tasks_per_s\": {:.1f}, \"allocations_per_task\": {:.3f}}}{}\n",
+			                    r.Name, r.Pool, r.Threads, r.Tasks, r.Seconds, static_cast<double>(r.Tasks) / r.Seconds, r.AllocationsPerTask,
+			                    i + 1 < results.size() ? "," : "");
+		}
+		json += "  ]\n}\n";
+		return json;
+	}
+}// namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--quick") {
+			options.Quick = true;
+		} else if (arg == "--out" && i + 1 < argc) {
+			options.OutputPath = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--out results.json]\n";
+			return 1;
+		}
+	}
+
+	std::vector<Result> results;
+	for (size_t threads: {1, 2, 4, 8, 16, 32, 64}) {
+		BenchPool<Reference::ThreadPool>(options, "single_queue", threads, results);
+		BenchPool<ThreadPool>(options, "work_stealing", threads, results);
+	}
+
+	for (const Result& r: results) {
+		std::cerr << fmt::format("{:<20} {:<14} {:>3} threads  {:>12.0f} tasks/s  {:>6.2f} allocations/task\n", r.Name, r.Pool, r.Threads,
+		                         static_cast<double>(r.Tasks) / r.Seconds, r.AllocationsPerTask);
+	}
+
+	const std::string json = ToJson(results);
+	if (options.OutputPath.empty()) {
+		std::cout << json;
+	} else {
+		std::ofstream out(options.OutputPath);
+		out << json;
+		if (!out) {
+			std::cerr << "Failed to write " << options.OutputPath << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Appx {
+	constexpr uint64_t BLOCK_SIZE = 64 * 1024;
+
+	struct BlockMapFile {
+		std::string Name;                    // package relative, '\' separated and not percent-encoded
+		uint64_t Size = 0;
+		std::vector<std::string> BlockHashes;// base64 SHA-256 of every uncompressed 64 KB block
+		std::string FileHash;                // base64 SHA-256 of the whole file
+	};
+
+	std::optional<std::vector<BlockMapFile>> ParseBlockMap(const std::filesystem::path& path);
+
+	// AppxManifest.xml gets a new identity in every install, so its content never matches the block map
+	bool IsPerInstanceFile(const BlockMapFile& file);
+
+	// Loose package folders keep the percent-encoded names from the .appx archive ("ic@2x.png" is stored as "ic%402x.png")
+	std::string EncodeName(const std::string& name);
+	std::filesystem::path ResolvePath(const std::filesystem::path& root, const BlockMapFile& file);
+}// namespace Appx
@@ -0,0 +1,30 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "appx/BlockMap.h"
+
+namespace Appx {
+	// Keeps every distinct package file once under objects/, keyed by the SHA-256 the block map gives for it.
+	// Template versions and instances are hardlinked out of the store, so they all share the same file data.
+	class ContentStore {
+	public:
+		using Fetcher = std::function<bool(const BlockMapFile& file, const std::filesystem::path& destination)>;
+
+		explicit ContentStore(std::filesystem::path root) : m_Root(std::move(root)) {}
+
+		bool Contains(const BlockMapFile& file) const;
+		std::filesystem::path ObjectPath(const BlockMapFile& file) const;
+
+		size_t Import(const std::filesystem::path& packageDir, const std::vector<BlockMapFile>& files);
+		std::vector<BlockMapFile> Fetch(const std::vector<BlockMapFile>& files, const Fetcher& fetcher);
+		bool Materialize(const std::vector<BlockMapFile>& files, const std::filesystem::path& dst) const;
+
+	private:
+		bool Adopt(const std::filesystem::path& source, const BlockMapFile& file, bool link);
+
+		std::filesystem::path m_Root;
+	};
+}// namespace Appx
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "appx/BlockMap.h"
+
+namespace Appx {
+	struct DeltaStats {
+		uint64_t BlocksTotal = 0;
+		uint64_t BlocksWritten = 0;
+	};
+
+	std::optional<DeltaStats> RefreshFile(const std::filesystem::path& source, const std::filesystem::path& target, const BlockMapFile& expected);
+	bool RecoverJournal(const std::filesystem::path& target);
+}// namespace Appx
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "appx/BlockMap.h"
+#include "utils/threadpool/ThreadPool.hpp"
+
+namespace Appx {
+	struct FileIssue {
+		enum class Kind {
+			Missing,
+			SizeMismatch,
+			HashMismatch
+		};
+
+		BlockMapFile File;
+		Kind Problem = Kind::Missing;
+		std::vector<size_t> BadBlocks;
+	};
+
+	struct IntegrityReport {
+		std::filesystem::path PackageDir;
+		size_t FilesChecked = 0;
+		uint64_t BytesChecked = 0;
+		std::vector<FileIssue> Issues;
+
+		bool IsClean() const { return Issues.empty(); }
+	};
+
+	// Checks package folders against the block hashes of their own AppxBlockMap.xml. Files are mapped and hashed
+	// on a shared pool, and data that several instances share through hardlinks is hashed only once per scan.
+	class IntegrityScanner {
+	public:
+		explicit IntegrityScanner(size_t maxConcurrency = std::thread::hardware_concurrency());
+
+		std::vector<IntegrityReport> Scan(const std::vector<std::filesystem::path>& packageDirs);
+		IntegrityReport Scan(const std::filesystem::path& packageDir);
+
+		// Replaces the damaged files with the template's copies, after checking those copies are intact themselves
+		static bool Repair(const IntegrityReport& report, const std::filesystem::path& templateDir);
+
+	private:
+		ThreadPool m_Pool;
+	};
+}// namespace Appx
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "utils/filesystem/MappedFile.h"
+
+namespace Appx {
+	// The whole template packed into one file: a header, an index sorted by path and the file payloads, each
+	// starting on a page boundary. The file is mapped once and instances are written straight out of the mapping.
+	class TemplateImage {
+	public:
+		static constexpr uint64_t PAYLOAD_ALIGNMENT = 4096;
+
+		struct Entry {
+			std::string_view Path;
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			bool IsDirectory = false;
+		};
+
+		// Template -> Template.pack, next to the folder it was packed from
+		static std::filesystem::path ImagePathFor(const std::filesystem::path& templateDir) {
+			auto imagePath = templateDir;
+			imagePath += ".pack";
+			return imagePath;
+		}
+
+		static bool Build(const std::filesystem::path& sourceDir, const std::filesystem::path& imagePath);
+		static std::unique_ptr<TemplateImage> Open(const std::filesystem::path& imagePath);
+
+		// Changes whenever a file in sourceDir is added, removed, resized or written to. An image keeps the one of
+		// the folder it was packed from, so a stale image can be told apart without reading any file.
+		static std::optional<uint64_t> Fingerprint(const std::filesystem::path& sourceDir);
+		uint64_t SourceFingerprint() const { return m_SourceFingerprint; }
+
+		TemplateImage(const TemplateImage&) = delete;
+		TemplateImage& operator=(const TemplateImage&) = delete;
+
+		const std::vector<Entry>& Entries() const { return m_Entries; }
+		std::optional<Entry> Find(std::string_view path) const;
+		std::span<const std::byte> Data(const Entry& entry) const;
+
+		bool Materialize(const std::filesystem::path& dst, size_t maxConcurrency = std::thread::hardware_concurrency()) const;
+
+	private:
+		TemplateImage() = default;
+
+		bool WriteEntry(const Entry& entry, const std::filesystem::path& target) const;
+
+		MappedFile m_File;
+		std::vector<Entry> m_Entries;
+		uint64_t m_SourceFingerprint = 0;
+	};
+}// namespace Appx
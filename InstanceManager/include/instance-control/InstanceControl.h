@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -19,6 +20,7 @@ public:
 	bool TerminateInstance(const std::string& username);
 	bool IsInstanceRunning(const std::string& username);
 	bool CreateInstance(const std::string& name);
+	bool CreateInstances(const std::vector<std::string>& names);
 
 	std::vector<std::string> GetInstanceNames() const;
 
@@ -46,13 +48,16 @@ public:
 
 	void CreateGroup(const GroupCreationInfo& info);
 
-	ImU32 GetColor(const std::string& username) { return std::get<ImU32>(this->m_Instances[username]); };
+	ImU32 GetColor(const std::string& username);
 
 private:
 	InstanceControl() = default;
 
 	friend InstanceControl& GetPrivateInstance();
 
+	// Launches, creates and deletes on different lanes touch the maps at once. Entries are never moved while they
+	// exist, so a reference to one stays good after the lock is released.
+	mutable std::mutex m_InstancesMutex;
 	std::unordered_map<std::string, std::tuple<Roblox::Instance, ImU32>> m_Instances = Roblox::ProcessRobloxPackages();
 	std::unordered_map<std::string, std::unique_ptr<Manager>> m_LaunchedInstances;
 	std::unordered_map<std::string, std::unique_ptr<Group>> m_Groups;
@@ -1,6 +1,7 @@
 #pragma once
 #include <set>
 #include <string>
+#include <vector>
 #define NOMINMAX
 #include <shlobj.h>
 #include <shlobj_core.h>
@@ -19,6 +20,7 @@ namespace Native {
 	winrt::com_ptr<IShellItemArray> CreateShellItemArrayFromProtocol(const winrt::hstring& protocolURI);
 	DWORD LaunchUWPAppWithProtocol(const winrt::hstring& appID, const winrt::hstring& protocolURI);
 	bool InstallUWPApp(const winrt::hstring& packagePath);
+	std::vector<bool> InstallUWPApps(const std::vector<winrt::hstring>& packagePaths);
 	bool RemoveUWPApp(const winrt::hstring& packageFullName);
 	std::optional<DWORD> LaunchAppWithProtocol(const std::string& appName, const std::string& AppID, const std::string& protocolString);
 
@@ -32,7 +34,4 @@ namespace Native {
 	void PerformMouseAction(int x_mid, int y_mid, std::optional<int> y_offset = std::nullopt);
 
 	std::set<DWORD> GetInstancesOf(const char* exeName);
-
-	typedef std::string (*ExtractFunction)(const unsigned char*, size_t);
-	std::string SearchEntireProcessMemory(HANDLE pHandle, const unsigned char* pattern, size_t patternSize, ExtractFunction extractFunction);
 }// namespace Native
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -46,6 +47,7 @@ namespace Roblox {
 	std::string EnterCode(const std::string& code, std::string cookie);
 	std::string ValidateCode(const std::string& code, std::string cookie);
 	std::string ExtractCode(const unsigned char* data, size_t dataSize);
-	std::string FindCodeValue(HANDLE pHandle);
+	// Every code value in the process, the most likely first. Keeps looking for up to timeout while there is none.
+	std::vector<std::string> FindCodeValues(HANDLE pHandle, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
 	std::vector<std::string> GetNewInstances(const std::vector<std::string>& old_instances);
 }// namespace Roblox
\ No newline at end of file
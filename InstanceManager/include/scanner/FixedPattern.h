@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "scanner/Pattern.h"
+
+namespace Scanner {
+	// A signature parsed by the compiler. Value is already masked and the anchors are chosen, so turning it into a
+	// Pattern is a copy.
+	template <size_t N>
+	struct FixedPattern {
+		std::array<uint8_t, N> Value{};
+		std::array<uint8_t, N> Mask{};
+		PatternAnchors Anchors;
+	};
+
+	namespace Detail {
+		template <size_t L>
+		struct SignatureText {
+			char Text[L]{};
+
+			consteval SignatureText(const char (&text)[L]) { std::copy_n(text, L, Text); }
+
+			constexpr std::string_view View() const { return std::string_view(Text, L - 1); }
+		};
+
+		// A token that is neither a wildcard nor one or two hex digits reaches the throw, which a consteval
+		// function can't evaluate, so a malformed signature fails to compile
+		consteval int HexDigit(char c) {
+			if (c >= '0' && c <= '9') return c - '0';
+			if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+			throw "signature contains a character that is not a hex digit";
+		}
+
+		// Calls visit(value, mask) for every token, the same grammar Pattern::Parse accepts
+		template <typename Visitor>
+		consteval void ForEachToken(std::string_view signature, Visitor visit) {
+			while (!signature.empty()) {
+				const size_t end = signature.find(' ');
+				const std::string_view token = signature.substr(0, end);
+				signature = end == std::string_view::npos ? std::string_view() : signature.substr(end + 1);
+
+				if (token.empty()) {
+					continue;
+				}
+
+				if (token == "?" || token == "??") {
+					visit(uint8_t{0}, uint8_t{0x00});
+				} else if (token.size() <= 2) {
+					int byte = 0;
+					for (char c: token) {
+						byte = byte * 16 + HexDigit(c);
+					}
+					visit(static_cast<uint8_t>(byte), uint8_t{0xFF});
+				} else {
+					throw "signature token is longer than one byte";
+				}
+			}
+		}
+
+		consteval size_t CountTokens(std::string_view signature) {
+			size_t count = 0;
+			ForEachToken(signature, [&](uint8_t, uint8_t) { ++count; });
+			if (count == 0) {
+				throw "signature is empty";
+			}
+			return count;
+		}
+
+		template <SignatureText S>
+		consteval auto CompileSignature() {
+			FixedPattern<CountTokens(S.View())> pattern;
+
+			size_t i = 0;
+			ForEachToken(S.View(), [&](uint8_t value, uint8_t mask) {
+				pattern.Value[i] = value & mask;
+				pattern.Mask[i] = mask;
+				++i;
+			});
+
+			pattern.Anchors = ChooseAnchors(pattern.Value, pattern.Mask);
+			return pattern;
+		}
+	}// namespace Detail
+
+	inline namespace Literals {
+		// "6B 65 ?? 3D"_pattern
+		template <Detail::SignatureText S>
+		consteval auto operator""_pattern() {
+			return Detail::CompileSignature<S>();
+		}
+	}// namespace Literals
+}// namespace Scanner
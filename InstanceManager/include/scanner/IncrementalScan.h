@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "scanner/MemorySearch.h"
+#include "scanner/PatternSet.h"
+
+namespace Scanner {
+	// Scans one process pass after pass, only looking again at pages that changed since the pass before. Changes
+	// come from the backend's write tracking where it has one (soft-dirty bits on Linux). Otherwise every page is
+	// hashed and compared with its hash from the previous pass, which still reads the page but skips the pattern scan.
+	class IncrementalScan {
+	public:
+		IncrementalScan(const ProcessMemory& memory, const std::vector<Pattern>& patterns);
+
+		// The first pass scans everything. Later ones report only matches that overlap a changed page, so an unchanged
+		// match is reported once. The callback works as it does for ScanMemory.
+		bool Next(const MemoryMatchCallback& onMatch);
+
+		// Bytes the last pass ran the patterns over
+		uint64_t LastScannedBytes() const { return m_LastScannedBytes; }
+
+	private:
+		struct TrackedRegion {
+			size_t Size = 0;
+			std::vector<uint64_t> PageHashes;// empty while writes are tracked by the backend
+		};
+
+		// One hash per page of every region, the regions are hashed in parallel
+		std::vector<std::vector<uint64_t>> HashPages(const std::vector<MemoryRegion>& regions) const;
+
+		const ProcessMemory& m_Memory;
+		PatternSet m_Patterns;
+		std::unordered_map<uintptr_t, TrackedRegion> m_Regions;
+		bool m_Tracking = false;
+		size_t m_Passes = 0;
+		uint64_t m_LastScannedBytes = 0;
+	};
+}// namespace Scanner
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "scanner/MemorySearch.h"
+#include "scanner/PatternSet.h"
+#include "scanner/ProcessMemory.h"
+#include "scanner/RegionReader.h"
+
+class ThreadPool;
+
+namespace Scanner {
+	// Part of a region to scan. Matches are reported when they start inside [Begin, Begin + Size), reading may go
+	// on to the end of the region so they are seen whole.
+	struct ScanRange {
+		MemoryRegion Region;
+		uintptr_t Begin = 0;
+		size_t Size = 0;
+	};
+
+	// Runs a PatternSet over regions on a shared pool, the engine under ScanMemory, SearchMemory and IncrementalScan.
+	// Matches go to the handler, which can lower the cutoff: nothing at or above it is read or reported from then on.
+	class MemoryScan {
+	public:
+		// How far past a match its Data reaches at least, a match closer than this to a window's end is taken from the next window
+		static constexpr size_t EXTRACT_SLACK = 4096;
+		// Large ranges are cut into chunks of this size, so one huge region doesn't end up on a single worker.
+		// Small ranges are read together, up to this many bytes per batched read.
+		static constexpr size_t CHUNK_SIZE = 8 * RegionReader::DEFAULT_WINDOW_SIZE;
+
+		// Called from several workers at once
+		using MatchHandler = std::function<void(const MemoryMatch& match)>;
+
+		MemoryScan(const ProcessMemory& memory, const PatternSet& patterns, MatchHandler onMatch);
+
+		// Can run more than once, the cutoff is kept across runs. Work is queued in the order given.
+		void Run(const std::vector<MemoryRegion>& regions);
+		void Run(const std::vector<ScanRange>& ranges);
+
+		void LowerCutoff(uintptr_t address);
+		void Stop() { LowerCutoff(0); }
+		bool Stopped() const { return m_Cutoff.load(std::memory_order_relaxed) == 0; }
+
+		// Some memory the layout listed was gone, the layout is out of date
+		bool HadReadFailures() const { return m_ReadFailed.load(std::memory_order_relaxed); }
+
+		// The workers every scan runs on, sized to the machine
+		static ThreadPool& Pool();
+
+	private:
+		bool PastCutoff(uintptr_t address) const {
+			return address >= m_Cutoff.load(std::memory_order_relaxed);
+		}
+
+		bool Visit(const RegionReader::Window& window, const MemoryRegion& region);
+		void ScanChunk(const MemoryRegion& region, uintptr_t base, size_t size);
+		void ScanBatch(const std::vector<ScanRange>& ranges);
+
+		const ProcessMemory& m_Memory;
+		const PatternSet& m_Patterns;
+		MatchHandler m_OnMatch;
+		size_t m_Overlap;
+
+		std::atomic<uintptr_t> m_Cutoff = UINTPTR_MAX;
+		std::atomic<bool> m_ReadFailed = false;
+	};
+}// namespace Scanner
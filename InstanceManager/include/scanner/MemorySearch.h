@@ -0,0 +1,39 @@
+#pragma once
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "scanner/Pattern.h"
+#include "scanner/ProcessMemory.h"
+
+namespace Scanner {
+	struct MemoryMatch {
+		size_t PatternIndex = 0;
+		uintptr_t Address = 0;
+		MemoryRegion Region;
+		// From the match to as far as the scan had read, at least the pattern and normally a few KB past it
+		std::span<const uint8_t> Data;
+	};
+
+	// Returns false to stop the scan
+	using MemoryMatchCallback = std::function<bool(const MemoryMatch& match)>;
+
+	// Reports every match of every pattern. Regions are scanned in parallel, the callback is called from the
+	// scan's workers one call at a time, in no particular order. False when the callback stopped the scan.
+	//
+	// Only the regions RegionCache considers worth scanning are searched, mapped images are not. The process's
+	// layout is cached between calls.
+	bool ScanMemory(const ProcessMemory& memory, const std::vector<Pattern>& patterns, const MemoryMatchCallback& onMatch);
+
+	using ExtractFunction = std::string (*)(const unsigned char* data, size_t size);
+
+	struct SearchRule {
+		Pattern Signature;
+		ExtractFunction Extract;
+	};
+
+	// Rules are in priority order, a value found by an earlier rule beats any value found by a later one. The
+	// result is the one a front to back scan would give, scans stop early once nothing left can beat it.
+	std::string SearchMemory(const ProcessMemory& memory, const std::vector<SearchRule>& rules);
+}// namespace Scanner
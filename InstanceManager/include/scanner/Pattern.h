@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Scanner {
+	template <size_t N>
+	struct FixedPattern;
+
+	// Rough byte frequencies in process memory: zero fill, 0xFF fill and padding, small integers, then text
+	constexpr int ByteCommonness(uint8_t byte) {
+		if (byte == 0x00) return 100;
+		if (byte == 0xFF) return 90;
+		if (byte == 0xCC || byte == 0x20) return 70;
+		if (byte < 0x10) return 65;
+		if (std::string_view("etaoinsrhl").find(static_cast<char>(byte)) != std::string_view::npos) return 60;
+		if (byte >= 'a' && byte <= 'z') return 50;
+		if (byte >= '0' && byte <= '9') return 45;
+		if (byte >= 'A' && byte <= 'Z') return 40;
+		if (byte < 0x80) return 30;
+		return 20;
+	}
+
+	struct PatternAnchors {
+		size_t First = 0;
+		size_t Second = 0;
+	};
+
+	// The rarest fixed byte filters best, the second anchor is the next rarest, as far from the first as possible.
+	// Usable at compile time, so signature literals come with their anchors already chosen.
+	constexpr PatternAnchors ChooseAnchors(std::span<const uint8_t> value, std::span<const uint8_t> mask) {
+		PatternAnchors anchors;
+
+		int bestScore = INT32_MAX;
+		for (size_t i = 0; i < value.size(); ++i) {
+			if (mask[i] == 0xFF && ByteCommonness(value[i]) < bestScore) {
+				bestScore = ByteCommonness(value[i]);
+				anchors.First = i;
+			}
+		}
+
+		anchors.Second = anchors.First;
+		bestScore = INT32_MAX;
+		size_t bestDistance = 0;
+		for (size_t i = 0; i < value.size(); ++i) {
+			if (i == anchors.First || mask[i] != 0xFF) {
+				continue;
+			}
+
+			const int score = ByteCommonness(value[i]);
+			const size_t distance = i > anchors.First ? i - anchors.First : anchors.First - i;
+			if (score < bestScore || (score == bestScore && distance > bestDistance)) {
+				bestScore = score;
+				bestDistance = distance;
+				anchors.Second = i;
+			}
+		}
+
+		return anchors;
+	}
+
+	// A byte signature with a mask instead of a wildcard marker, so every byte value can be matched literally.
+	// Mask 0xFF means the byte has to match, 0x00 means anything goes.
+	//
+	// Searching filters candidates on the two rarest fixed bytes (the anchors) and confirms them with a masked
+	// compare, using AVX2 or SSE2 when the CPU has them.
+	class Pattern {
+	public:
+		Pattern() = default;
+		Pattern(std::vector<uint8_t> value, std::vector<uint8_t> mask);
+
+		// From a "6B 65 ?? 3D"_pattern literal, which was parsed and had its anchors chosen at compile time
+		template <size_t N>
+		Pattern(const FixedPattern<N>& fixed)
+		    : m_Value(fixed.Value.begin(), fixed.Value.end()), m_Mask(fixed.Mask.begin(), fixed.Mask.end()),
+		      m_Anchor(fixed.Anchors.First), m_SecondAnchor(fixed.Anchors.Second) {}
+
+		// "6B 65 ?? 3D", a single '?' works as a wildcard as well
+		static std::optional<Pattern> Parse(std::string_view signature);
+		static Pattern FromBytes(std::span<const uint8_t> bytes);
+
+		size_t Size() const { return m_Value.size(); }
+		bool Empty() const { return m_Value.empty(); }
+		std::span<const uint8_t> Value() const { return m_Value; }
+		std::span<const uint8_t> Mask() const { return m_Mask; }
+
+		size_t AnchorOffset() const { return m_Anchor; }
+		size_t SecondAnchorOffset() const { return m_SecondAnchor; }
+
+		enum class Kernel {
+			Auto,
+			Scalar,
+			Sse2,
+			Avx2
+		};
+
+		bool MatchesAt(const uint8_t* data) const;
+		std::optional<size_t> Find(std::span<const uint8_t> data) const;
+		// With a given kernel, for comparing them. One the CPU can't run falls back to the best it can.
+		std::optional<size_t> Find(std::span<const uint8_t> data, Kernel kernel) const;
+
+	private:
+		std::vector<uint8_t> m_Value;
+		std::vector<uint8_t> m_Mask;
+		size_t m_Anchor = 0;
+		size_t m_SecondAnchor = 0;
+	};
+}// namespace Scanner
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "scanner/Pattern.h"
+
+namespace Scanner {
+	struct PatternMatch {
+		size_t PatternIndex = 0;
+		size_t Offset = 0;
+	};
+
+	// Finds several masked patterns in one pass with a Shift-And automaton. Patterns are packed side by side into
+	// 64-bit state words, one bit per pattern byte, and a wildcard simply accepts every byte at its position.
+	// Patterns longer than 64 bytes run their first 64 bytes through the automaton and are confirmed afterwards.
+	class PatternSet {
+	public:
+		// Returns false to stop the scan
+		using MatchCallback = std::function<bool(const PatternMatch& match)>;
+
+		size_t Add(Pattern pattern);
+
+		const Pattern& Get(size_t index) const { return m_Patterns[index]; }
+		size_t Count() const { return m_Patterns.size(); }
+		size_t MaxPatternSize() const { return m_MaxPatternSize; }
+
+		// Reports matches in the order they end. False when the callback stopped the scan.
+		bool Scan(std::span<const uint8_t> data, const MatchCallback& onMatch) const;
+
+	private:
+		static constexpr size_t WORD_BITS = 64;
+
+		struct StateWord {
+			std::array<uint64_t, 256> Accept{};
+			uint64_t Start = 0;
+			uint64_t Final = 0;
+			size_t BitsUsed = 0;
+			std::vector<std::pair<size_t, size_t>> Finals;// (final bit, pattern index)
+		};
+
+		size_t NextStart(std::span<const uint8_t> data, size_t from) const;
+		bool ScanSingle(std::span<const uint8_t> data, const MatchCallback& onMatch) const;
+		bool Report(std::span<const uint8_t> data, size_t end, const StateWord& word, uint64_t hits, const MatchCallback& onMatch) const;
+
+		std::vector<Pattern> m_Patterns;
+		std::vector<size_t> m_PrefixSizes;
+		std::vector<StateWord> m_Words;
+		std::vector<uint8_t> m_StartBytes;// bytes that can begin a match, empty when there are too many to skip on
+		size_t m_MaxPatternSize = 0;
+	};
+}// namespace Scanner
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Scanner {
+	struct MemoryRegion {
+		uintptr_t Base = 0;
+		size_t Size = 0;
+		bool Readable = false;
+		bool Writable = false;
+		bool Executable = false;
+		bool IsImage = false;  // mapped from an executable or library file
+		bool IsPrivate = false;// heap, stacks and other memory that is not shared with anything
+	};
+
+	struct ReadRequest {
+		uintptr_t Address = 0;
+		uint8_t* Buffer = nullptr;
+		size_t Size = 0;
+		size_t BytesRead = 0;
+	};
+
+	// Read access to another process's address space, so the scanner doesn't depend on the platform's API
+	class ProcessMemory {
+	public:
+		static constexpr size_t PAGE_BYTES = 4096;
+
+		virtual ~ProcessMemory() = default;
+
+		virtual uint32_t Pid() const = 0;
+		// When the process started, in the platform's own units. Tells a process apart from a later one with the same pid.
+		virtual uint64_t StartTime() const = 0;
+
+		virtual std::vector<MemoryRegion> Regions() const = 0;
+
+		// Returns how many bytes were copied, 0 when the range is unreadable
+		virtual size_t Read(uintptr_t address, uint8_t* buffer, size_t size) const = 0;
+
+		// Fills in BytesRead of every request. Backends that can read many ranges in one call override this.
+		virtual void ReadBatch(std::span<ReadRequest> requests) const;
+
+		// Write tracking, for backends that can tell which pages the process wrote to. Starts a new interval, false
+		// when the backend or the system can't track writes.
+		virtual bool ResetWriteTracking() const;
+
+		// Sets written[i] for every page of [base, base + size) written to since the last ResetWriteTracking. False
+		// when that isn't known, every page has to be assumed changed then.
+		virtual bool WrittenPages(uintptr_t base, size_t size, std::vector<bool>& written) const;
+
+		static std::unique_ptr<ProcessMemory> Open(uint32_t pid);
+#ifdef _WIN32
+		// Reads through a handle the caller keeps open, it needs PROCESS_VM_READ and PROCESS_QUERY_INFORMATION
+		static std::unique_ptr<ProcessMemory> FromHandle(void* processHandle);
+#endif
+	};
+}// namespace Scanner
@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "scanner/ProcessMemory.h"
+
+namespace Scanner {
+	// Remembers, per process, which regions are worth scanning and in which order, so a repeated search doesn't walk
+	// the whole address space again. Mapped images, guard pages and unreadable memory are left out, private
+	// read-write memory goes first since that is where heap data lives.
+	//
+	// A cached layout can miss regions allocated since it was taken. Searches check that with Refresh when the
+	// cached regions don't give them a definite answer.
+	class RegionCache {
+	public:
+		static constexpr std::chrono::seconds MAX_AGE{30};
+
+		struct Plan {
+			std::vector<MemoryRegion> Regions;
+			bool Fresh = false;// just read from the process, not taken from the cache
+		};
+
+		static RegionCache& GetInstance() {
+			static RegionCache instance;
+			return instance;
+		}
+
+		Plan Get(const ProcessMemory& memory);
+
+		// Reads the layout again and returns the regions the previous plan didn't have
+		std::vector<MemoryRegion> Refresh(const ProcessMemory& memory);
+
+		void Invalidate(const ProcessMemory& memory);
+
+		// Drops unscannable regions and orders the rest by how likely they are to hold heap data
+		static std::vector<MemoryRegion> Prioritize(std::vector<MemoryRegion> regions);
+
+	private:
+		RegionCache() = default;
+
+		struct Entry {
+			uint64_t StartTime = 0;
+			std::chrono::steady_clock::time_point TakenAt;
+			std::vector<MemoryRegion> Regions;
+		};
+
+		// Call with m_Mutex held
+		void DropExpired(std::chrono::steady_clock::time_point now);
+
+		std::mutex m_Mutex;
+		std::unordered_map<uint32_t, Entry> m_Entries;
+	};
+}// namespace Scanner
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace Scanner {
+	// Reads a memory region in fixed windows through one buffer that is kept between regions and scans, so peak
+	// memory is a single window no matter how large the target's regions are.
+	//
+	// Every window is read with `overlap` extra bytes from the next one. A visitor only reports matches that start
+	// in the window's first Owned bytes, the rest are seen again, whole, at the start of the next window.
+	class RegionReader {
+	public:
+		static constexpr size_t DEFAULT_WINDOW_SIZE = 1024 * 1024;
+
+		struct Window {
+			uintptr_t Address = 0;
+			std::span<const uint8_t> Data;
+			size_t Owned = 0;
+		};
+
+		// Copies up to size bytes at address into buffer and returns how many it got, 0 if the window is unreadable
+		using ReadFunction = std::function<size_t(uintptr_t address, uint8_t* buffer, size_t size)>;
+		// Returns false to stop reading
+		using WindowVisitor = std::function<bool(const Window& window)>;
+
+		explicit RegionReader(size_t windowSize = DEFAULT_WINDOW_SIZE) : m_WindowSize(windowSize) {}
+
+		// False when the visitor stopped early. readableTail is how much memory after base + size may still be read for
+		// the overlap, for ranges that are only part of a region.
+		bool ForEachWindow(uintptr_t base, size_t size, size_t overlap, const ReadFunction& read, const WindowVisitor& visit, size_t readableTail = 0);
+
+		size_t GetWindowSize() const { return m_WindowSize; }
+
+	private:
+		size_t m_WindowSize;
+		std::vector<uint8_t> m_Buffer;
+	};
+}// namespace Scanner
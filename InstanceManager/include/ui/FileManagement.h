@@ -2,6 +2,7 @@
 #include "Base.hpp"
 #include "imgui.h"
 #include "instance-control/InstanceControl.h"
+#include "utils/filesystem/DirectoryIndex.h"
 #include "utils/filesystem/FS.h"
 
 namespace fs = std::filesystem;
@@ -20,13 +21,10 @@ private:
 	std::vector<std::string>& instances;
 	std::vector<bool>& selection;
 
-	struct DirectoryEntryInfo {
-		fs::directory_entry entry;
-		std::string filename;
-		std::string uniqueId;
-	};
-	std::unordered_map<std::string, std::vector<DirectoryEntryInfo>> cache;
+	// One index per package folder, keyed by package family name
+	std::unordered_map<std::string, std::unique_ptr<DirectoryIndex>> indexes;
 
-	void DisplayFilesAndDirectories(const std::string& packageFamilyName, const std::filesystem::path& directory, bool forceRefresh = false);
+	DirectoryIndex* GetIndex(const Roblox::Instance& instance);
+	void DisplayFilesAndDirectories(DirectoryIndex& index, const std::string& packageFamilyName, const std::filesystem::path& directory);
 	void CloneDir(const std::string& packageFamilyName, const std::filesystem::path& full_src_path);
 };
\ No newline at end of file
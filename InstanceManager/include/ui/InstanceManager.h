@@ -1,8 +1,13 @@
 #pragma once
+#include <functional>
+#include <mutex>
+#include <vector>
+
 #include "Base.hpp"
 #include "FileManagement.h"
 #include "ui/AppLog.h"
 #include "ui/AutoRelaunch.h"
+#include "utils/threadpool/LaneExecutor.hpp"
 #include "utils/threadpool/ThreadPool.hpp"
 
 class InstanceManager : public AppBase<InstanceManager> {
@@ -14,8 +19,14 @@ public:
 	void Update() override;
 
 private:
+	// Instance list edits from background tasks, applied on the UI thread at the start of a frame so the names and
+	// the selection always change together. Declared before the lanes, whose tasks still queue edits while they drain.
+	std::mutex m_ListEditsMutex;
+	std::vector<std::function<void()>> m_ListEdits;
+
 	ThreadPool m_ThreadPool;
-	ThreadPool m_QueuedThreadPool;
+	// Background work, one lane per instance name plus "template" and "launch"
+	LaneExecutor m_Lanes;
 	FileManagement m_FileManagement;
 	AutoRelaunch m_AutoRelaunch;
 	AppLog m_AppLog;
@@ -31,8 +42,12 @@ private:
 	void RenderUpdateTemplate();
 	void RenderContextMenu(int n);
 	void RenderUpdateInstance();
+	void RenderVerifyInstances();
 	bool AnyInstanceSelected();
 
+	void QueueListEdit(std::function<void()> edit);
+	void ApplyListEdits();
+
 	void SubmitDeleteTask(int idx);
 	void RenderLaunch();
 };
\ No newline at end of file
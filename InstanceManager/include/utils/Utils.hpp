@@ -10,14 +10,20 @@
 
 
 namespace Utils {
-	std::vector<unsigned char> ParsePattern(const std::string& pattern);
+	enum class InstanceUpdate {
+		Updated,
+		AlreadyCurrent,
+		Failed,
+	};
+
 	void ModifyAppxManifest(const std::filesystem::path& filePath, const std::string& name);
-	uintptr_t BoyerMooreHorspool(const unsigned char* signature, size_t signatureSize, const unsigned char* data, size_t dataSize);
 	void DownloadAndSave(const std::string& url, const std::string& localFileName);
 	void DecompressZip(const std::string& zipFile, const std::string& destination);
 	void CopyFileToDestination(const std::string& source, const std::string& destination);
 	void WriteAppxManifest(const std::string& url, const std::string& localPath, const std::string& name = "");
 	void UpdatePackage(const std::string& baseFolder, const std::string& instanceName = "");
+	bool UpdateTemplate(const std::string& templateFolder);
+	InstanceUpdate UpdateInstance(const std::string& templateFolder, const std::string& instanceFolder, const std::string& instanceName);
 	bool SaveScreenshotAsPng(const char* filename);
 	std::pair<int, int> MatchTemplate(const std::string& template_path, double threshold);
 
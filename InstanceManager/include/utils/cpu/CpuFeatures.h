@@ -0,0 +1,12 @@
+#pragma once
+
+// Instruction set extensions the hot loops can dispatch on, detected once with cpuid
+struct CpuFeatures {
+	bool Sse2 = false;
+	bool Ssse3 = false;
+	bool Sse41 = false;
+	bool Avx2 = false;
+	bool Sha = false;
+
+	static const CpuFeatures& Get();
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+#include "utils/threadpool/ThreadPool.hpp"
+
+// Deletes directory trees one at a time in the background. Inside a tree the unlinks are spread over a small pool,
+// whose size is the I/O budget, so bulk deletions queue up instead of all hitting the disk at once.
+class DeletionService {
+public:
+	using CompletionCallback = std::function<void(bool success)>;
+
+	static DeletionService& GetInstance() {
+		static DeletionService instance;
+		return instance;
+	}
+
+	DeletionService(const DeletionService&) = delete;
+	DeletionService& operator=(const DeletionService&) = delete;
+
+	// With moveToTrash the path is renamed into a .trash folder next to it before this returns, so it can be reused right away
+	void Enqueue(const std::filesystem::path& path, bool moveToTrash = true, CompletionCallback onComplete = nullptr);
+	void EmptyTrash(const std::filesystem::path& parent);
+
+	size_t Pending();
+
+private:
+	static constexpr size_t IO_BUDGET = 4;
+	static constexpr size_t FILES_PER_TASK = 64;
+
+	struct Job {
+		std::filesystem::path path;
+		std::string label;
+		CompletionCallback onComplete;
+	};
+
+	DeletionService();
+	~DeletionService();
+
+	void Worker();
+	bool DeleteTree(const Job& job);
+
+	std::queue<Job> m_Queue;
+	std::mutex m_QueueMutex;
+	std::condition_variable m_Condition;
+	bool m_Stop = false;
+
+	ThreadPool m_UnlinkPool;
+	std::thread m_WorkerThread;
+};
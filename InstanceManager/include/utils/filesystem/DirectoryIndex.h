@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define NOMINMAX
+#include <windows.h>
+
+// Cached listing of a directory tree. A directory is read once when it is first asked for and then only again after
+// ReadDirectoryChangesW reports a change in it, so UI code can call List every frame without touching the disk.
+class DirectoryIndex {
+public:
+	struct Entry {
+		std::filesystem::path path;
+		std::string filename;
+		std::string uniqueId;
+		bool isDirectory = false;
+		bool isRegularFile = false;
+	};
+
+	using Listing = std::shared_ptr<const std::vector<Entry>>;
+
+	explicit DirectoryIndex(std::filesystem::path root);
+	~DirectoryIndex();
+
+	DirectoryIndex(const DirectoryIndex&) = delete;
+	DirectoryIndex& operator=(const DirectoryIndex&) = delete;
+
+	Listing List(const std::filesystem::path& directory);
+	void Invalidate();
+
+	const std::filesystem::path& GetRoot() const { return m_Root; }
+
+private:
+	static Listing ReadDirectory(const std::filesystem::path& directory);
+
+	void StartWatching();
+	void StopWatching();
+	void WatchLoop();
+	void MarkDirty(const std::filesystem::path& directory);
+
+	std::filesystem::path m_Root;
+
+	std::mutex m_Mutex;
+	std::unordered_map<std::string, Listing> m_Listings;
+	std::unordered_set<std::string> m_Dirty;
+
+	std::atomic_bool m_Stop = false;
+	std::thread m_WatchThread;
+
+	HANDLE m_DirectoryHandle = INVALID_HANDLE_VALUE;
+	HANDLE m_StopEvent = NULL;
+};
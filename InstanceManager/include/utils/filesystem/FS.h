@@ -1,12 +1,35 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace FS {
-	bool CopyDirectory(const std::filesystem::path& src, const std::filesystem::path& dst);
+	struct CopyProgress {
+		std::atomic<uint64_t> bytesCopied{0};
+		std::atomic<uint64_t> bytesTotal{0};
+		std::atomic<size_t> filesCopied{0};
+		std::atomic<size_t> filesTotal{0};
+	};
+
+	struct CopyOptions {
+		size_t maxConcurrency = std::thread::hardware_concurrency();// upper bound on copies in flight
+		uint64_t chunkSize = 8 * 1024 * 1024;                        // files larger than this are split into chunks
+		CopyProgress* progress = nullptr;
+	};
+
+	struct ExtractOptions {
+		size_t maxThreads = std::thread::hardware_concurrency();
+		size_t memoryCap = 64 * 1024 * 1024;// read buffers of all extraction threads together stay below this
+	};
+
+	bool CopyDirectory(const std::filesystem::path& src, const std::filesystem::path& dst, const CopyOptions& options = {});
+	bool CloneDirectory(const std::filesystem::path& src, const std::filesystem::path& dst, const std::vector<std::filesystem::path>& privateFiles);
 	bool RemovePath(const std::filesystem::path& path_to_delete);
-	bool DecompressZip(const std::string& zipPath, const std::string& destination);
+	bool SyncFile(const std::filesystem::path& path);
+	bool DecompressZip(const std::string& zipPath, const std::string& destination, const ExtractOptions& options = {});
 	bool DecompressZipToFile(const std::string& zipPath, const std::string& destination);
 	std::vector<std::string> FindFiles(const std::string& path, const std::string& substring);
 }// namespace FS
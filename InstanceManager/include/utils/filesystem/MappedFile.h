@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+// Read-only view of a whole file. Empty files open fine and give an empty span.
+class MappedFile {
+public:
+	// Same value for every hardlink of a file, so shared data can be recognised without reading it
+	struct Identity {
+		uint64_t Device = 0;
+		uint64_t Index = 0;
+
+		bool operator==(const Identity&) const = default;
+	};
+
+	MappedFile() = default;
+	explicit MappedFile(const std::filesystem::path& path) { Open(path); }
+	MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	bool IsOpen() const { return m_IsOpen; }
+	explicit operator bool() const { return m_IsOpen; }
+
+	std::span<const std::byte> Data() const { return {m_View, static_cast<size_t>(m_Size)}; }
+	uint64_t Size() const { return m_Size; }
+	Identity GetIdentity() const { return m_Identity; }
+
+#ifndef _WIN32
+	int Descriptor() const { return m_Fd; }
+#endif
+
+private:
+	const std::byte* m_View = nullptr;
+	uint64_t m_Size = 0;
+	Identity m_Identity;
+	bool m_IsOpen = false;
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_Fd = -1;
+#endif
+};
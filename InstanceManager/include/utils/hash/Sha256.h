@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+class Sha256 {
+public:
+	using Digest = std::array<uint8_t, 32>;
+
+	Sha256() { Reset(); }
+
+	void Reset();
+	void Update(const void* data, size_t size);
+	Digest Final();
+
+	static Digest Hash(const void* data, size_t size);
+	static std::optional<Digest> HashFile(const std::filesystem::path& path);
+
+private:
+	void Transform(const uint8_t* blocks, size_t count);
+
+	std::array<uint32_t, 8> m_State;
+	std::array<uint8_t, 64> m_Buffer;
+	size_t m_BufferSize;
+	uint64_t m_TotalSize;
+};
@@ -1,7 +1,14 @@
 #pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace StringUtils {
 	bool ContainsOnly(const std::string& s, char c);
+	std::string Base64Encode(std::span<const uint8_t> data);
+	std::optional<std::vector<uint8_t>> Base64Decode(const std::string& s);
+	std::string ToHex(std::span<const uint8_t> data);
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Recycles fixed-size blocks. Every thread keeps its own free list and trades whole batches with a shared depot,
+// so a block freed on another thread than the one that allocated it still comes back without a trip to the heap.
+template<size_t BlockSize>
+class BlockCache {
+	static_assert(BlockSize >= sizeof(void*));
+
+	// A free block holds the next free block
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	static constexpr size_t BATCH = 32;
+
+	struct Depot {
+		std::mutex mutex;
+		std::vector<FreeBlock*> batches;// each the head of a chain of BATCH blocks
+	};
+
+	// Never destroyed, blocks can be returned by threads that outlive static destruction
+	static Depot& SharedDepot() {
+		static Depot* depot = new Depot();
+		return *depot;
+	}
+
+	struct LocalList {
+		FreeBlock* head = nullptr;
+		size_t count = 0;
+
+		~LocalList() {
+			Destroyed() = true;
+			while (count >= BATCH) {
+				GiveBatch(*this);
+			}
+			while (head) {
+				FreeBlock* next = head->next;
+				::operator delete(head);
+				head = next;
+			}
+		}
+	};
+
+	static LocalList& Local() {
+		thread_local LocalList list;
+		return list;
+	}
+
+	// Set once the thread's list is gone, blocks freed by later thread_local destructors go straight to the heap
+	static bool& Destroyed() {
+		thread_local bool destroyed = false;
+		return destroyed;
+	}
+
+	static void GiveBatch(LocalList& list) {
+		FreeBlock* batch = list.head;
+		FreeBlock* last = batch;
+		for (size_t i = 1; i < BATCH; ++i) {
+			last = last->next;
+		}
+		list.head = last->next;
+		list.count -= BATCH;
+		last->next = nullptr;
+
+		Depot& depot = SharedDepot();
+		std::scoped_lock lock(depot.mutex);
+		depot.batches.push_back(batch);
+	}
+
+public:
+	static void* Allocate() {
+		if (Destroyed()) {
+			return ::operator new(BlockSize);
+		}
+
+		LocalList& list = Local();
+		if (!list.head) {
+			Depot& depot = SharedDepot();
+			std::scoped_lock lock(depot.mutex);
+			if (depot.batches.empty()) {
+				return ::operator new(BlockSize);
+			}
+			list.head = depot.batches.back();
+			list.count = BATCH;
+			depot.batches.pop_back();
+		}
+
+		FreeBlock* block = list.head;
+		list.head = block->next;
+		--list.count;
+		return block;
+	}
+
+	static void Deallocate(void* pointer) {
+		if (Destroyed()) {
+			::operator delete(pointer);
+			return;
+		}
+
+		LocalList& list = Local();
+		list.head = new (pointer) FreeBlock{list.head};
+		++list.count;
+
+		// A thread that only frees passes what it doesn't need on to the ones that allocate
+		if (list.count >= 2 * BATCH) {
+			GiveBatch(list);
+		}
+	}
+};
+
+// Allocator for the shared state behind a std::promise, which comes out of a BlockCache when it fits one
+template<typename T>
+struct RecyclingAllocator {
+	using value_type = T;
+
+	RecyclingAllocator() = default;
+	template<typename U>
+	RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+	T* allocate(size_t n) {
+		const size_t bytes = n * sizeof(T);
+		if (alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			if (bytes <= 64) return static_cast<T*>(BlockCache<64>::Allocate());
+			if (bytes <= 128) return static_cast<T*>(BlockCache<128>::Allocate());
+			if (bytes <= 256) return static_cast<T*>(BlockCache<256>::Allocate());
+		}
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* pointer, size_t n) noexcept {
+		const size_t bytes = n * sizeof(T);
+		if (alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			if (bytes <= 64) return BlockCache<64>::Deallocate(pointer);
+			if (bytes <= 128) return BlockCache<128>::Deallocate(pointer);
+			if (bytes <= 256) return BlockCache<256>::Deallocate(pointer);
+		}
+		std::allocator<T>().deallocate(pointer, n);
+	}
+
+	template<typename U>
+	bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/threadpool/ThreadPool.hpp"
+
+// Runs tasks on a shared pool, serialized per lane. Tasks on one lane run one at a time in the order they were
+// submitted, tasks on different lanes run side by side. A task submitted on several lanes waits until it is first
+// in all of them and holds them all while it runs, which orders it against everything queued on each. SubmitBehind
+// orders a task after a lane without holding it.
+class LaneExecutor {
+public:
+	explicit LaneExecutor(ThreadPool& pool) : m_Pool(pool) {}
+
+	// Waits for every queued task
+	~LaneExecutor();
+
+	LaneExecutor(const LaneExecutor&) = delete;
+	LaneExecutor& operator=(const LaneExecutor&) = delete;
+
+	template<class F, class... Args>
+	auto SubmitTask(std::vector<std::string> lanes, Callback cb, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>>;
+
+	template<class F, class... Args>
+	auto SubmitTask(std::vector<std::string> lanes, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>> {
+		return SubmitTask(std::move(lanes), nullptr, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	// Starts delay after the task reaches the front of all its lanes, which it holds while it waits. The wait is a
+	// timer on the pool, not a blocked worker.
+	template<class Rep, class Period, class F, class... Args>
+	auto SubmitAfter(std::vector<std::string> lanes, std::chrono::duration<Rep, Period> delay, Callback cb, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>>;
+
+	// Also waits for every task already queued on the behind lanes, without joining them, so tasks submitted on
+	// those lanes later don't wait for this one and tasks that share none of its own lanes still run side by side.
+	template<class F, class... Args>
+	auto SubmitBehind(std::vector<std::string> lanes, std::vector<std::string> behind, Callback cb, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>>;
+
+private:
+	struct Job {
+		TaskWrapper Task;
+		std::vector<std::string> Lanes;
+		ThreadPool::Clock::duration Delay{};
+		std::vector<std::string> Behind;
+		size_t Waiting = 0;// lanes this job isn't first in yet, and jobs it is behind that haven't finished
+		std::vector<std::shared_ptr<Job>> Dependents;// jobs behind this one
+	};
+
+	void Submit(std::shared_ptr<Job> job);
+	void Run(std::shared_ptr<Job> job);
+
+	ThreadPool& m_Pool;
+
+	std::mutex m_Mutex;
+	std::unordered_map<std::string, std::deque<std::shared_ptr<Job>>> m_Lanes;
+	size_t m_Unfinished = 0;
+	std::condition_variable m_Idle;
+};
+
+template<class F, class... Args>
+auto LaneExecutor::SubmitTask(std::vector<std::string> lanes, Callback cb, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+	return SubmitAfter(std::move(lanes), ThreadPool::Clock::duration::zero(), std::move(cb), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class Rep, class Period, class F, class... Args>
+auto LaneExecutor::SubmitAfter(std::vector<std::string> lanes, std::chrono::duration<Rep, Period> delay, Callback cb, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+	auto [result, task] = ThreadPool::Package(std::move(cb), std::forward<F>(f), std::forward<Args>(args)...);
+	Submit(std::make_shared<Job>(Job{std::move(task), std::move(lanes), std::chrono::duration_cast<ThreadPool::Clock::duration>(delay), {}, 0, {}}));
+	return std::move(result);
+}
+
+template<class F, class... Args>
+auto LaneExecutor::SubmitBehind(std::vector<std::string> lanes, std::vector<std::string> behind, Callback cb, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+	auto [result, task] = ThreadPool::Package(std::move(cb), std::forward<F>(f), std::forward<Args>(args)...);
+	Submit(std::make_shared<Job>(Job{std::move(task), std::move(lanes), ThreadPool::Clock::duration::zero(), std::move(behind), 0, {}}));
+	return std::move(result);
+}
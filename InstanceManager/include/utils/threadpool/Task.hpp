@@ -0,0 +1,226 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "utils/threadpool/ThreadPool.hpp"
+
+// A result that a pool is still working on, which further work can be chained onto. Every stage of a graph is
+// queued on the pool the moment its inputs are ready, so stages that don't depend on each other overlap without
+// anyone arranging it. Copies share the one result, each Then on it starts its own branch.
+template<typename T>
+class Task;
+
+namespace Tasks {
+	namespace Detail {
+		// void results are kept as monostate, so every state holds a value the same way
+		template<typename T>
+		using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+		// What a continuation of a Task<T> returns, it gets no argument when T is void
+		template<typename F, typename T>
+		struct ThenResult {
+			using type = std::invoke_result_t<F, const T&>;
+		};
+
+		template<typename F>
+		struct ThenResult<F, void> {
+			using type = std::invoke_result_t<F>;
+		};
+
+		template<typename T>
+		struct State {
+			explicit State(ThreadPool& pool) : Pool(pool) {}
+
+			void Resolve(std::optional<Stored<T>> value, std::exception_ptr error) {
+				std::vector<TaskWrapper> ready;
+				{
+					std::scoped_lock lock(Mutex);
+					Value = std::move(value);
+					Error = std::move(error);
+					Done = true;
+					ready.swap(Continuations);
+				}
+				Finished.notify_all();
+
+				for (auto& continuation: ready) {
+					Pool.Post(std::move(continuation));
+				}
+			}
+
+			void OnDone(TaskWrapper continuation) {
+				{
+					std::scoped_lock lock(Mutex);
+					if (!Done) {
+						Continuations.push_back(std::move(continuation));
+						return;
+					}
+				}
+				Pool.Post(std::move(continuation));
+			}
+
+			void Wait() {
+				std::unique_lock lock(Mutex);
+				Finished.wait(lock, [this] { return Done; });
+			}
+
+			// Calls f with the result and resolves the state with what f returns or throws
+			template<typename F, typename... Args>
+			void Complete(F& f, Args&&... args) {
+				try {
+					if constexpr (std::is_void_v<T>) {
+						std::invoke(f, std::forward<Args>(args)...);
+						Resolve(std::monostate{}, nullptr);
+					} else {
+						Resolve(std::invoke(f, std::forward<Args>(args)...), nullptr);
+					}
+				} catch (...) {
+					Resolve(std::nullopt, std::current_exception());
+				}
+			}
+
+			ThreadPool& Pool;
+			std::mutex Mutex;
+			std::condition_variable Finished;
+			bool Done = false;
+			std::optional<Stored<T>> Value;// set once Done, unless the task threw
+			std::exception_ptr Error;
+			std::vector<TaskWrapper> Continuations;
+		};
+	}// namespace Detail
+
+	template<class F, class... Args>
+	auto Run(ThreadPool& pool, F&& f, Args&&... args) -> Task<std::invoke_result_t<F, Args...>>;
+
+	template<typename T>
+	auto WhenAll(ThreadPool& pool, std::vector<Task<T>> tasks) -> Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>;
+}// namespace Tasks
+
+template<typename T>
+class Task {
+public:
+	Task() = default;
+
+	bool Valid() const { return m_State != nullptr; }
+
+	// Queues f on the pool once this task is done, with the result as its argument unless the result is void. If
+	// this task threw, f is skipped and the returned task holds the same exception.
+	template<class F>
+	auto Then(F&& f) const;
+
+	void Wait() const { m_State->Wait(); }
+
+	// Blocks until done, then returns the result or rethrows what the task threw
+	decltype(auto) Get() const {
+		m_State->Wait();
+		if (m_State->Error) {
+			std::rethrow_exception(m_State->Error);
+		}
+		if constexpr (!std::is_void_v<T>) {
+			return static_cast<const T&>(*m_State->Value);
+		}
+	}
+
+private:
+	explicit Task(std::shared_ptr<Tasks::Detail::State<T>> state) : m_State(std::move(state)) {}
+
+	template<typename>
+	friend class Task;
+
+	template<class F, class... Args>
+	friend auto Tasks::Run(ThreadPool& pool, F&& f, Args&&... args) -> Task<std::invoke_result_t<F, Args...>>;
+
+	template<typename U>
+	friend auto Tasks::WhenAll(ThreadPool& pool, std::vector<Task<U>> tasks) -> Task<std::conditional_t<std::is_void_v<U>, void, std::vector<U>>>;
+
+	std::shared_ptr<Tasks::Detail::State<T>> m_State;
+};
+
+template<typename T>
+template<class F>
+auto Task<T>::Then(F&& f) const {
+	using Result = typename Tasks::Detail::ThenResult<F, T>::type;
+
+	auto next = std::make_shared<Tasks::Detail::State<Result>>(m_State->Pool);
+	m_State->OnDone(TaskWrapper([previous = m_State, next, f = std::forward<F>(f)]() mutable {
+		if (previous->Error) {
+			next->Resolve(std::nullopt, previous->Error);
+		} else if constexpr (std::is_void_v<T>) {
+			next->Complete(f);
+		} else {
+			next->Complete(f, static_cast<const T&>(*previous->Value));
+		}
+	}));
+
+	return Task<Result>(std::move(next));
+}
+
+namespace Tasks {
+	// Queues f on the pool now, the start of a graph
+	template<class F, class... Args>
+	auto Run(ThreadPool& pool, F&& f, Args&&... args) -> Task<std::invoke_result_t<F, Args...>> {
+		using Result = std::invoke_result_t<F, Args...>;
+
+		auto state = std::make_shared<Detail::State<Result>>(pool);
+		pool.Post([state, f = std::forward<F>(f), args_tuple = std::tuple{std::forward<Args>(args)...}]() mutable {
+			auto call = [&f, &args_tuple]() -> Result { return std::apply(f, args_tuple); };
+			state->Complete(call);
+		});
+
+		return Task<Result>(std::move(state));
+	}
+
+	// Done once every task is, with their results in the order given. Fails with the first exception in that order
+	// if any of them threw.
+	template<typename T>
+	auto WhenAll(ThreadPool& pool, std::vector<Task<T>> tasks) -> Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> {
+		using Result = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+		auto all = std::make_shared<Detail::State<Result>>(pool);
+		auto inputs = std::make_shared<const std::vector<Task<T>>>(std::move(tasks));
+		auto remaining = std::make_shared<std::atomic<size_t>>(inputs->size());
+
+		// Resolved by whichever input finishes last, on the worker that finished it
+		auto finish = [all, inputs]() {
+			for (const auto& task: *inputs) {
+				if (task.m_State->Error) {
+					all->Resolve(std::nullopt, task.m_State->Error);
+					return;
+				}
+			}
+
+			if constexpr (std::is_void_v<T>) {
+				all->Resolve(std::monostate{}, nullptr);
+			} else {
+				std::vector<T> values;
+				values.reserve(inputs->size());
+				for (const auto& task: *inputs) {
+					values.push_back(*task.m_State->Value);
+				}
+				all->Resolve(std::move(values), nullptr);
+			}
+		};
+
+		if (inputs->empty()) {
+			finish();
+		}
+
+		for (const auto& task: *inputs) {
+			task.m_State->OnDone(TaskWrapper([remaining, finish]() {
+				if (remaining->fetch_sub(1) == 1) {
+					finish();
+				}
+			}));
+		}
+
+		return Task<Result>(std::move(all));
+	}
+}// namespace Tasks
@@ -1,46 +1,122 @@
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <optional>
-#include <queue>
+#include <new>
+#include <stdexcept>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "utils/threadpool/BlockCache.hpp"
+#include "utils/threadpool/TimerWheel.hpp"
+#include "utils/threadpool/WorkStealingDeque.hpp"
+
 using Callback = std::function<void()>;
 
 
+// Move-only callable. One that fits INLINE_SIZE is stored in place, a bigger one on the heap.
 class TaskWrapper {
-	struct ITask {
-		virtual ~ITask() = default;
-		virtual void execute() = 0;
-	};
-
-	template<typename Func>
-	struct TaskHolder : ITask {
-		explicit TaskHolder(Func&& func) : func_(std::move(func)) {}
-		void execute() override { func_(); }
-		Func func_;
-	};
-
-	std::unique_ptr<ITask> task_;
-
 public:
+	static constexpr size_t INLINE_SIZE = 192;
+
 	template<class Func>
+	        requires(!std::is_same_v<std::decay_t<Func>, TaskWrapper>)
 	explicit TaskWrapper(Func&& func) {
-		task_ = std::make_unique<TaskHolder<Func>>(std::move(func));
+		using Stored = std::decay_t<Func>;
+		if constexpr (FitsInline<Stored>) {
+			new (storage_) Stored(std::forward<Func>(func));
+			ops_ = &InlineOps<Stored>;
+		} else {
+			*reinterpret_cast<Stored**>(storage_) = new Stored(std::forward<Func>(func));
+			ops_ = &HeapOps<Stored>;
+		}
 	}
 
+	TaskWrapper(TaskWrapper&& other) noexcept : ops_(other.ops_) {
+		if (ops_) {
+			ops_->move(storage_, other.storage_);
+			other.ops_ = nullptr;
+		}
+	}
+
+	TaskWrapper& operator=(TaskWrapper&& other) noexcept {
+		if (this != &other) {
+			reset();
+			ops_ = other.ops_;
+			if (ops_) {
+				ops_->move(storage_, other.storage_);
+				other.ops_ = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	TaskWrapper(const TaskWrapper&) = delete;
+	TaskWrapper& operator=(const TaskWrapper&) = delete;
+
+	~TaskWrapper() { reset(); }
+
 	void operator()() {
-		task_->execute();
+		ops_->invoke(storage_);
+	}
+
+private:
+	struct Ops {
+		void (*invoke)(void*);
+		void (*move)(void* to, void* from);// also destroys the moved-from callable
+		void (*destroy)(void*);
+	};
+
+	template<class Func>
+	static constexpr bool FitsInline = sizeof(Func) <= INLINE_SIZE && alignof(Func) <= alignof(std::max_align_t) &&
+	                                   std::is_nothrow_move_constructible_v<Func>;
+
+	template<class Func>
+	static constexpr Ops InlineOps = {
+	        [](void* p) { (*static_cast<Func*>(p))(); },
+	        [](void* to, void* from) {
+		        new (to) Func(std::move(*static_cast<Func*>(from)));
+		        static_cast<Func*>(from)->~Func();
+	        },
+	        [](void* p) { static_cast<Func*>(p)->~Func(); },
+	};
+
+	template<class Func>
+	static constexpr Ops HeapOps = {
+	        [](void* p) { (**static_cast<Func**>(p))(); },
+	        [](void* to, void* from) { *static_cast<Func**>(to) = *static_cast<Func**>(from); },
+	        [](void* p) { delete *static_cast<Func**>(p); },
+	};
+
+	void reset() {
+		if (ops_) {
+			ops_->destroy(storage_);
+			ops_ = nullptr;
+		}
 	}
+
+	alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+	const Ops* ops_ = nullptr;
 };
 
+// Every worker owns a deque. A task submitted from a worker goes on that worker's deque, one submitted from any
+// other thread goes on a shared injection queue, and a worker with nothing of its own to run takes from the
+// injection queue or steals from the other workers. With one worker, tasks submitted from outside the pool run in
+// the order they were submitted.
+//
+// Timed tasks wait on a timer wheel, not on a worker. One thread per pool, started with the first timed task,
+// advances the wheel and queues each task once it is due.
 class ThreadPool {
 public:
+	using Clock = TimerWheel::Clock;
+
 	explicit ThreadPool(size_t num_threads);
 
 	~ThreadPool();
@@ -55,43 +131,141 @@ public:
 		return SubmitTask(nullptr, std::forward<F>(f), std::forward<Args>(args)...);
 	}
 
+	// Fire and forget, no future is made. An exception that escapes the task ends the program, as it would on a
+	// std::thread.
+	template<class F, class... Args>
+	void Post(F&& f, Args&&... args);
+
+	// Timed tasks run within a tick of their time. Ones still waiting when the pool is destroyed are dropped, their
+	// futures get broken_promise.
+	template<class F, class... Args>
+	auto SubmitAt(Clock::time_point when, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>>;
+
+	template<class Rep, class Period, class F, class... Args>
+	auto SubmitAfter(std::chrono::duration<Rep, Period> delay, F&& f, Args&&... args)
+	        -> std::future<std::invoke_result_t<F, Args...>> {
+		return SubmitAt(Clock::now() + delay, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	template<class F, class... Args>
+	void PostAt(Clock::time_point when, F&& f, Args&&... args);
+
+	template<class Rep, class Period, class F, class... Args>
+	void PostAfter(std::chrono::duration<Rep, Period> delay, F&& f, Args&&... args) {
+		PostAt(Clock::now() + delay, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	// Wraps f so that it runs cb after itself and hands its result or exception to the returned future
+	template<class F, class... Args>
+	static auto Package(Callback cb, F&& f, Args&&... args)
+	        -> std::pair<std::future<std::invoke_result_t<F, Args...>>, TaskWrapper>;
+
 private:
+	// Tasks live in recycled blocks, so queueing one doesn't touch the heap once the pool has warmed up
+	template<class Func>
+	TaskWrapper* MakeTask(Func&& func);
+	void Schedule(TaskWrapper* task);
+	void ScheduleAt(Clock::time_point when, TaskWrapper* task);
+	void TimerLoop();
+	static void Release(TaskWrapper* task);
+	TaskWrapper* FindTask(size_t index);
+	void WorkerLoop(size_t index);
+
+	std::vector<std::unique_ptr<WorkStealingDeque<TaskWrapper>>> queues;
 	std::vector<std::thread> workers;
-	std::queue<TaskWrapper> tasks;
 
-	std::mutex queue_mutex;
+	// A ring that only ever grows, so steady injection doesn't allocate
+	std::mutex injection_mutex;
+	std::vector<TaskWrapper*> injected;
+	size_t injected_head = 0;
+	std::atomic<size_t> injected_count{0};// lets idle workers skip the lock while nothing is injected
+
+	// Queued tasks that no worker has taken yet, sleeping workers wait for it to go above zero
+	std::atomic<size_t> pending{0};
+	std::atomic<size_t> sleeping{0};
+	std::mutex sleep_mutex;
 	std::condition_variable condition;
-	bool stop = false;
+	std::atomic<bool> stop{false};
+
+	std::mutex timer_mutex;
+	std::condition_variable timer_condition;
+	TimerWheel timers;
+	std::thread timer_thread;
+	bool timer_stop = false;
 };
 
+template<class Func>
+TaskWrapper* ThreadPool::MakeTask(Func&& func) {
+	if (stop.load(std::memory_order_relaxed)) {
+		throw std::runtime_error("SubmitTask on stopped ThreadPool");
+	}
+
+	return new (BlockCache<sizeof(TaskWrapper)>::Allocate()) TaskWrapper(std::forward<Func>(func));
+}
+
 template<class F, class... Args>
-auto ThreadPool::SubmitTask(Callback cb, F&& f, Args&&... args)
-        -> std::future<std::invoke_result_t<F, Args...>> {
+auto ThreadPool::Package(Callback cb, F&& f, Args&&... args)
+        -> std::pair<std::future<std::invoke_result_t<F, Args...>>, TaskWrapper> {
 	using return_type = std::invoke_result_t<F, Args...>;
 
-	auto task_function = [f = std::forward<F>(f), cb, args_tuple = std::tuple{std::forward<Args>(args)...}]() -> return_type {
-		if constexpr (std::is_same_v<return_type, void>) {
-			std::apply(f, args_tuple);
-			if (cb) cb();
-		} else {
-			auto result = std::apply(f, args_tuple);
-			if (cb) cb();
-			return result;
+	// The promise's shared state is recycled too
+	std::promise<return_type> promise(std::allocator_arg, RecyclingAllocator<return_type>());
+	std::future<return_type> result = promise.get_future();
+
+	TaskWrapper task([promise = std::move(promise), f = std::forward<F>(f), cb = std::move(cb), args_tuple = std::tuple{std::forward<Args>(args)...}]() mutable {
+		try {
+			if constexpr (std::is_same_v<return_type, void>) {
+				std::apply(f, args_tuple);
+				if (cb) cb();
+				promise.set_value();
+			} else {
+				auto value = std::apply(f, args_tuple);
+				if (cb) cb();
+				promise.set_value(std::move(value));
+			}
+		} catch (...) {
+			promise.set_exception(std::current_exception());
 		}
-	};
+	});
 
+	return {std::move(result), std::move(task)};
+}
 
-	std::packaged_task<return_type()> packaged(std::move(task_function));
-	std::future<return_type> result = packaged.get_future();
+template<class F, class... Args>
+auto ThreadPool::SubmitTask(Callback cb, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+	auto [result, task] = Package(std::move(cb), std::forward<F>(f), std::forward<Args>(args)...);
+	Schedule(MakeTask(std::move(task)));
+	return std::move(result);
+}
 
-	{
-		std::scoped_lock<std::mutex> lock(queue_mutex);
-		if (stop) {
-			throw std::runtime_error("SubmitTask on stopped ThreadPool");
-		}
-		tasks.emplace(std::move(packaged));
+template<class F, class... Args>
+void ThreadPool::Post(F&& f, Args&&... args) {
+	if constexpr (sizeof...(Args) == 0) {
+		Schedule(MakeTask(std::forward<F>(f)));
+	} else {
+		Schedule(MakeTask([f = std::forward<F>(f), args_tuple = std::tuple{std::forward<Args>(args)...}]() mutable {
+			std::apply(f, args_tuple);
+		}));
 	}
+}
 
-	condition.notify_one();
-	return result;
-}
\ No newline at end of file
+template<class F, class... Args>
+auto ThreadPool::SubmitAt(Clock::time_point when, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+	auto [result, task] = Package(nullptr, std::forward<F>(f), std::forward<Args>(args)...);
+	ScheduleAt(when, MakeTask(std::move(task)));
+	return std::move(result);
+}
+
+template<class F, class... Args>
+void ThreadPool::PostAt(Clock::time_point when, F&& f, Args&&... args) {
+	if constexpr (sizeof...(Args) == 0) {
+		ScheduleAt(when, MakeTask(std::forward<F>(f)));
+	} else {
+		ScheduleAt(when, MakeTask([f = std::forward<F>(f), args_tuple = std::tuple{std::forward<Args>(args)...}]() mutable {
+			std::apply(f, args_tuple);
+		}));
+	}
+}
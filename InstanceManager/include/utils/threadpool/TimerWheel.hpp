@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class TaskWrapper;
+
+// Hashed timer wheel. A timer sits in the slot its tick hashes to until the wheel comes round to that tick, so
+// adding one is O(1) and a tick only looks at one slot, however many timers are pending. Not synchronized.
+class TimerWheel {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t SLOTS = 512;
+	static constexpr std::chrono::milliseconds TICK{10};
+
+	TimerWheel() : m_Epoch(Clock::now()) {}
+	~TimerWheel();
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	// Due on the first tick at or after when
+	void Add(Clock::time_point when, TaskWrapper* task);
+
+	// Moves every task due by now into due, in no particular order
+	void Advance(Clock::time_point now, std::vector<TaskWrapper*>& due);
+
+	// Takes out every pending task, due or not
+	void Clear(std::vector<TaskWrapper*>& pending);
+
+	size_t Size() const { return m_Size; }
+
+	// When the wheel should next be advanced
+	Clock::time_point NextTick() const { return m_Epoch + TICK * (m_Tick + 1); }
+
+private:
+	struct Timer {
+		TaskWrapper* Task;
+		uint64_t Tick;
+		Timer* Next;
+	};
+
+	Clock::time_point m_Epoch;
+	uint64_t m_Tick = 0;// every timer up to this tick has been taken out
+	size_t m_Size = 0;
+	std::array<Timer*, SLOTS> m_Slots{};
+};
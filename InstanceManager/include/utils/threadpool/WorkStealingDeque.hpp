@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev deque. The owning thread pushes and takes at the bottom, any other thread steals from the top, none of
+// them take a lock. Holds pointers, nullptr means empty.
+template<typename T>
+class WorkStealingDeque {
+	struct Buffer {
+		explicit Buffer(int64_t capacity) : capacity(capacity), mask(capacity - 1), items(new std::atomic<T*>[capacity]) {}
+
+		T* Get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, T* item) { items[index & mask].store(item, std::memory_order_relaxed); }
+
+		int64_t capacity;
+		int64_t mask;
+		std::unique_ptr<std::atomic<T*>[]> items;
+	};
+
+public:
+	explicit WorkStealingDeque(int64_t capacity = 256) {
+		buffers.push_back(std::make_unique<Buffer>(capacity));
+		buffer.store(buffers.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	// Owner only
+	void Push(T* item) {
+		const int64_t b = bottom.load(std::memory_order_relaxed);
+		const int64_t t = top.load(std::memory_order_acquire);
+		Buffer* current = buffer.load(std::memory_order_relaxed);
+
+		if (b - t > current->capacity - 1) {
+			current = Grow(current, b, t);
+		}
+
+		current->Put(b, item);
+		bottom.store(b + 1, std::memory_order_release);
+	}
+
+	// Owner only, newest first
+	T* Take() {
+		const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* current = buffer.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T* item = current->Get(b);
+		if (t == b) {
+			// The last item, a thief may be after it too
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				item = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return item;
+	}
+
+	// Any thread, oldest first. nullptr when empty or when another thread got there first.
+	T* Steal() {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b) {
+			return nullptr;
+		}
+
+		T* item = buffer.load(std::memory_order_acquire)->Get(t);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return item;
+	}
+
+	bool Empty() const {
+		return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+	}
+
+private:
+	// A thief may still be reading the old buffer, so it is kept until the deque goes away
+	Buffer* Grow(Buffer* current, int64_t b, int64_t t) {
+		buffers.push_back(std::make_unique<Buffer>(current->capacity * 2));
+		Buffer* grown = buffers.back().get();
+		for (int64_t i = t; i < b; ++i) {
+			grown->Put(i, current->Get(i));
+		}
+		buffer.store(grown, std::memory_order_release);
+		return grown;
+	}
+
+	alignas(64) std::atomic<int64_t> top{0};
+	alignas(64) std::atomic<int64_t> bottom{0};
+	std::atomic<Buffer*> buffer{nullptr};
+	std::vector<std::unique_ptr<Buffer>> buffers;
+};
@@ -0,0 +1,96 @@
+#include "appx/BlockMap.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+
+#include "logging/CoreLogger.hpp"
+#include "tinyxml2.h"
+
+namespace Appx {
+	// SHA-256 of zero bytes, empty files have no blocks to take the hash from
+	constexpr const char* EMPTY_FILE_HASH = "47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=";
+
+	std::optional<std::vector<BlockMapFile>> ParseBlockMap(const std::filesystem::path& path) {
+		tinyxml2::XMLDocument doc;
+		if (doc.LoadFile(path.string().c_str()) != tinyxml2::XML_SUCCESS) {
+			CoreLogger::Log(LogLevel::ERR, "Failed to load block map {}", path.string());
+			return std::nullopt;
+		}
+
+		tinyxml2::XMLElement* root = doc.FirstChildElement("BlockMap");
+		if (!root) {
+			CoreLogger::Log(LogLevel::ERR, "{} is not a block map", path.string());
+			return std::nullopt;
+		}
+
+		std::vector<BlockMapFile> files;
+		for (auto* fileElement = root->FirstChildElement("File"); fileElement; fileElement = fileElement->NextSiblingElement("File")) {
+			const char* name = fileElement->Attribute("Name");
+			if (!name) {
+				continue;
+			}
+
+			BlockMapFile file;
+			file.Name = name;
+			file.Size = fileElement->Unsigned64Attribute("Size");
+
+			for (auto* block = fileElement->FirstChildElement("Block"); block; block = block->NextSiblingElement("Block")) {
+				if (const char* hash = block->Attribute("Hash")) {
+					file.BlockHashes.emplace_back(hash);
+				}
+			}
+
+			if (auto* fileHash = fileElement->FirstChildElement("b4:FileHash"); fileHash && fileHash->Attribute("Hash")) {
+				file.FileHash = fileHash->Attribute("Hash");
+			} else if (file.BlockHashes.size() == 1) {
+				file.FileHash = file.BlockHashes.front();// the only block is the whole file
+			} else if (file.Size == 0) {
+				file.FileHash = EMPTY_FILE_HASH;
+			}
+
+			if (file.FileHash.empty() || file.BlockHashes.size() != (file.Size + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+				CoreLogger::Log(LogLevel::WARNING, "Skipping malformed block map entry {}", file.Name);
+				continue;
+			}
+
+			files.push_back(std::move(file));
+		}
+
+		return files;
+	}
+
+	bool IsPerInstanceFile(const BlockMapFile& file) {
+		return file.Name == "AppxManifest.xml";
+	}
+
+	std::string EncodeName(const std::string& name) {
+		std::string encoded;
+		encoded.reserve(name.size());
+
+		for (unsigned char c: name) {
+			if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~' || c == '\\' || c == '/') {
+				encoded += static_cast<char>(c);
+			} else {
+				encoded += fmt::format("%{:02X}", c);
+			}
+		}
+
+		return encoded;
+	}
+
+	std::filesystem::path ResolvePath(const std::filesystem::path& root, const BlockMapFile& file) {
+		auto toPath = [](std::string name) {
+			std::ranges::replace(name, '\\', '/');
+			return std::filesystem::path(name);
+		};
+
+		auto encodedPath = root / toPath(EncodeName(file.Name));
+		if (std::filesystem::exists(encodedPath)) {
+			return encodedPath;
+		}
+
+		return root / toPath(file.Name);
+	}
+}// namespace Appx
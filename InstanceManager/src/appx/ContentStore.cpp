@@ -0,0 +1,170 @@
+#include "appx/ContentStore.h"
+
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+#include "logging/CoreLogger.hpp"
+#include "utils/hash/Sha256.h"
+#include "utils/string/StringUtils.h"
+
+namespace Appx {
+	namespace {
+		bool LinkOrCopy(const std::filesystem::path& src, const std::filesystem::path& dst) {
+			std::error_code ec;
+			std::filesystem::create_hard_link(src, dst, ec);
+			if (!ec) {
+				return true;
+			}
+
+			return std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing, ec);
+		}
+
+		// Text files lose their CR bytes in a git checkout or a raw download, while the block map hashes the CRLF
+		// original. Returns the file with CRLF line endings if that is what the block map describes.
+		std::optional<std::string> RestoreLineEndings(const std::filesystem::path& source, const BlockMapFile& file) {
+			std::error_code ec;
+			const uint64_t size = std::filesystem::file_size(source, ec);
+			if (ec || size >= file.Size) {
+				return std::nullopt;
+			}
+
+			std::ifstream in(source, std::ios::binary);
+			const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+			std::string restored;
+			restored.reserve(file.Size);
+			for (size_t i = 0; i < content.size(); ++i) {
+				if (content[i] == '\n' && (i == 0 || content[i - 1] != '\r')) {
+					restored += '\r';
+				}
+				restored += content[i];
+			}
+
+			if (restored.size() != file.Size || StringUtils::Base64Encode(Sha256::Hash(restored.data(), restored.size())) != file.FileHash) {
+				return std::nullopt;
+			}
+			return restored;
+		}
+	}// namespace
+
+	std::filesystem::path ContentStore::ObjectPath(const BlockMapFile& file) const {
+		auto digest = StringUtils::Base64Decode(file.FileHash);
+		std::string hex = digest ? StringUtils::ToHex(*digest) : std::string("invalid");
+		return m_Root / "objects" / hex.substr(0, 2) / hex;
+	}
+
+	bool ContentStore::Contains(const BlockMapFile& file) const {
+		return std::filesystem::exists(ObjectPath(file));
+	}
+
+	// Links the files a package directory already has into the store, so they never have to be downloaded again.
+	// Returns how many new objects were added.
+	size_t ContentStore::Import(const std::filesystem::path& packageDir, const std::vector<BlockMapFile>& files) {
+		size_t imported = 0;
+
+		for (const auto& file: files) {
+			if (Contains(file)) {
+				continue;
+			}
+
+			// Smaller is fine, a checked out text file may only be missing its CR bytes
+			auto path = ResolvePath(packageDir, file);
+			if (!std::filesystem::exists(path) || std::filesystem::file_size(path) > file.Size) {
+				continue;
+			}
+
+			if (Adopt(path, file, true)) {
+				++imported;
+			}
+		}
+
+		return imported;
+	}
+
+	// Asks the fetcher for every file the store doesn't have yet, unchanged files are never fetched or written.
+	// Returns the files that could not be fetched.
+	std::vector<BlockMapFile> ContentStore::Fetch(const std::vector<BlockMapFile>& files, const Fetcher& fetcher) {
+		std::filesystem::path staging = m_Root / "staging";
+		std::filesystem::create_directories(staging);
+
+		std::vector<BlockMapFile> failed;
+		for (const auto& file: files) {
+			if (Contains(file)) {
+				continue;
+			}
+
+			auto temp = staging / ObjectPath(file).filename();
+			if (!fetcher(file, temp) || !Adopt(temp, file, false)) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to fetch {}", file.Name);
+				failed.push_back(file);
+			}
+
+			std::error_code ec;
+			std::filesystem::remove(temp, ec);
+		}
+
+		return failed;
+	}
+
+	// Links every file of the package from the store into dst, files that are already the right object are left alone
+	bool ContentStore::Materialize(const std::vector<BlockMapFile>& files, const std::filesystem::path& dst) const {
+		bool success = true;
+
+		for (const auto& file: files) {
+			auto object = ObjectPath(file);
+			auto target = ResolvePath(dst, file);
+
+			std::error_code ec;
+			if (std::filesystem::equivalent(object, target, ec)) {
+				continue;
+			}
+
+			std::filesystem::create_directories(target.parent_path(), ec);
+			std::filesystem::remove(target, ec);
+
+			if (!LinkOrCopy(object, target)) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to materialize {} into {}", file.Name, dst.string());
+				success = false;
+			}
+		}
+
+		return success;
+	}
+
+	bool ContentStore::Adopt(const std::filesystem::path& source, const BlockMapFile& file, bool link) {
+		auto object = ObjectPath(file);
+		std::error_code ec;
+		std::filesystem::create_directories(object.parent_path(), ec);
+
+		auto digest = Sha256::HashFile(source);
+		if (!digest || StringUtils::Base64Encode(*digest) != file.FileHash) {
+			auto restored = RestoreLineEndings(source, file);
+			if (!restored) {
+				CoreLogger::Log(LogLevel::WARNING, "{} does not match its block map hash, not adding it to the store", source.string());
+				return false;
+			}
+
+			// The store keeps the bytes the block map describes, so this one is written out rather than linked
+			auto temp = object;
+			temp += ".tmp";
+			{
+				std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+				out.write(restored->data(), static_cast<std::streamsize>(restored->size()));
+				if (!out.flush()) {
+					return false;
+				}
+			}
+
+			std::filesystem::rename(temp, object, ec);
+			return !ec;
+		}
+
+		if (link) {
+			return LinkOrCopy(source, object);
+		}
+
+		std::filesystem::rename(source, object, ec);
+		return !ec || LinkOrCopy(source, object);
+	}
+}// namespace Appx
@@ -0,0 +1,232 @@
+#include "appx/DeltaUpdate.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "logging/CoreLogger.hpp"
+#include "utils/filesystem/FS.h"
+#include "utils/hash/Sha256.h"
+#include "utils/string/StringUtils.h"
+
+// A refresh never touches the target before every changed block has been written to <target>.delta and flushed.
+// The journal ends with a commit record, a journal without one is thrown away, a committed one is replayed until it sticks.
+//
+// Journal layout: magic, target size, then records of ('B', offset, length, data) and a final 'C'.
+namespace Appx {
+	namespace {
+		constexpr std::array<char, 8> JOURNAL_MAGIC = {'I', 'M', 'D', 'E', 'L', 'T', 'A', '1'};
+		constexpr char BLOCK_RECORD = 'B';
+		constexpr char COMMIT_RECORD = 'C';
+
+		std::filesystem::path JournalPath(const std::filesystem::path& target) {
+			auto journal = target;
+			journal += ".delta";
+			return journal;
+		}
+
+		template<typename T>
+		bool ReadValue(std::istream& in, T& value) {
+			return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+		}
+
+		template<typename T>
+		void WriteValue(std::ostream& out, const T& value) {
+			out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		bool IsCommitted(std::ifstream& journal) {
+			char tag;
+			while (ReadValue(journal, tag)) {
+				if (tag == COMMIT_RECORD) {
+					return true;
+				}
+
+				uint64_t offset;
+				uint32_t length;
+				if (tag != BLOCK_RECORD || !ReadValue(journal, offset) || !ReadValue(journal, length) || !journal.seekg(length, std::ios::cur)) {
+					return false;
+				}
+			}
+
+			return false;
+		}
+
+		bool ReplayJournal(const std::filesystem::path& journalPath, const std::filesystem::path& target) {
+			std::ifstream journal(journalPath, std::ios::binary);
+
+			std::array<char, 8> magic{};
+			uint64_t targetSize;
+			if (!journal.read(magic.data(), magic.size()) || magic != JOURNAL_MAGIC || !ReadValue(journal, targetSize)) {
+				return false;
+			}
+
+			auto recordsStart = journal.tellg();
+			if (!IsCommitted(journal)) {
+				return false;
+			}
+
+			journal.clear();
+			journal.seekg(recordsStart);
+
+			std::error_code ec;
+			std::filesystem::resize_file(target, targetSize, ec);
+			if (ec) {
+				return false;
+			}
+
+			{
+				std::fstream out(target, std::ios::binary | std::ios::in | std::ios::out);
+				std::vector<char> buffer(BLOCK_SIZE);
+
+				char tag;
+				while (ReadValue(journal, tag) && tag == BLOCK_RECORD) {
+					uint64_t offset;
+					uint32_t length;
+					if (!ReadValue(journal, offset) || !ReadValue(journal, length) || length > buffer.size() || !journal.read(buffer.data(), length)) {
+						return false;
+					}
+
+					out.seekp(static_cast<std::streamoff>(offset));
+					out.write(buffer.data(), length);
+				}
+
+				if (!out.flush()) {
+					return false;
+				}
+			}
+
+			return FS::SyncFile(target);
+		}
+	}// namespace
+
+	// Finishes or discards a refresh that was interrupted. Returns false only if a committed journal could not be applied.
+	bool RecoverJournal(const std::filesystem::path& target) {
+		auto journalPath = JournalPath(target);
+		if (!std::filesystem::exists(journalPath)) {
+			return true;
+		}
+
+		std::ifstream journal(journalPath, std::ios::binary);
+		std::array<char, 8> magic{};
+		uint64_t targetSize;
+		bool committed = journal.read(magic.data(), magic.size()) && magic == JOURNAL_MAGIC && ReadValue(journal, targetSize) && IsCommitted(journal);
+		journal.close();
+
+		if (committed) {
+			CoreLogger::Log(LogLevel::INFO, "Resuming interrupted update of {}", target.string());
+			if (!ReplayJournal(journalPath, target)) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to resume the update of {}", target.string());
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::remove(journalPath, ec);
+		return true;
+	}
+
+	// Brings target in line with source one 64 KB block at a time. Blocks of target are hashed and compared against the
+	// block map, and only the ones that differ are copied over from source.
+	std::optional<DeltaStats> RefreshFile(const std::filesystem::path& source, const std::filesystem::path& target, const BlockMapFile& expected) {
+		if (!RecoverJournal(target)) {
+			return std::nullopt;
+		}
+
+		DeltaStats stats;
+		stats.BlocksTotal = expected.BlockHashes.size();
+
+		std::error_code ec;
+		// Writing in place through a hardlink would change every other link too, so those get a private copy instead
+		if (!std::filesystem::exists(target) || std::filesystem::hard_link_count(target, ec) > 1) {
+			auto temp = target;
+			temp += ".tmp";
+			std::filesystem::copy_file(source, temp, std::filesystem::copy_options::overwrite_existing, ec);
+			if (!ec) std::filesystem::rename(temp, target, ec);
+			if (ec) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to copy {} to {}: {}", source.string(), target.string(), ec.message());
+				return std::nullopt;
+			}
+
+			stats.BlocksWritten = stats.BlocksTotal;
+			return stats;
+		}
+
+		const uint64_t targetSize = std::filesystem::file_size(target);
+
+		std::vector<size_t> changed;
+		{
+			std::ifstream in(target, std::ios::binary);
+			std::vector<char> buffer(BLOCK_SIZE);
+
+			for (size_t i = 0; i < expected.BlockHashes.size(); ++i) {
+				uint64_t offset = i * BLOCK_SIZE;
+				auto length = static_cast<size_t>(std::min<uint64_t>(BLOCK_SIZE, expected.Size - offset));
+
+				if (offset + length > targetSize || !in.seekg(static_cast<std::streamoff>(offset)) || !in.read(buffer.data(), static_cast<std::streamsize>(length)) ||
+				    StringUtils::Base64Encode(Sha256::Hash(buffer.data(), length)) != expected.BlockHashes[i]) {
+					changed.push_back(i);
+					in.clear();
+				}
+			}
+		}
+
+		if (changed.empty() && targetSize == expected.Size) {
+			return stats;
+		}
+
+		auto journalPath = JournalPath(target);
+		{
+			std::ifstream in(source, std::ios::binary);
+			std::ofstream journal(journalPath, std::ios::binary | std::ios::trunc);
+			std::vector<char> buffer(BLOCK_SIZE);
+
+			journal.write(JOURNAL_MAGIC.data(), JOURNAL_MAGIC.size());
+			WriteValue(journal, expected.Size);
+
+			for (size_t i: changed) {
+				uint64_t offset = i * BLOCK_SIZE;
+				auto length = static_cast<uint32_t>(std::min<uint64_t>(BLOCK_SIZE, expected.Size - offset));
+
+				if (!in.seekg(static_cast<std::streamoff>(offset)) || !in.read(buffer.data(), length) ||
+				    StringUtils::Base64Encode(Sha256::Hash(buffer.data(), length)) != expected.BlockHashes[i]) {
+					CoreLogger::Log(LogLevel::ERR, "{} does not match its block map, update the template first", source.string());
+					journal.close();
+					std::filesystem::remove(journalPath, ec);
+					return std::nullopt;
+				}
+
+				WriteValue(journal, BLOCK_RECORD);
+				WriteValue(journal, offset);
+				WriteValue(journal, length);
+				journal.write(buffer.data(), length);
+			}
+
+			if (!journal.flush() || !FS::SyncFile(journalPath)) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to write update journal {}", journalPath.string());
+				journal.close();
+				std::filesystem::remove(journalPath, ec);
+				return std::nullopt;
+			}
+
+			// Only a journal that made it to disk in full gets the commit record
+			WriteValue(journal, COMMIT_RECORD);
+			if (!journal.flush() || !FS::SyncFile(journalPath)) {
+				journal.close();
+				std::filesystem::remove(journalPath, ec);
+				return std::nullopt;
+			}
+		}
+
+		if (!ReplayJournal(journalPath, target)) {
+			CoreLogger::Log(LogLevel::ERR, "Failed to apply update journal to {}, it will be retried on the next update", target.string());
+			return std::nullopt;
+		}
+
+		std::filesystem::remove(journalPath, ec);
+
+		stats.BlocksWritten = changed.size();
+		return stats;
+	}
+}// namespace Appx
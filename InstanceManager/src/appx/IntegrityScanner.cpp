@@ -0,0 +1,183 @@
+#include "appx/IntegrityScanner.h"
+
+#include <algorithm>
+#include <future>
+#include <map>
+#include <optional>
+#include <tuple>
+
+#include "logging/CoreLogger.hpp"
+#include "utils/filesystem/MappedFile.h"
+#include "utils/hash/Sha256.h"
+#include "utils/string/StringUtils.h"
+
+namespace Appx {
+	namespace {
+		// Indices of the 64 KB blocks whose hash doesn't match the block map
+		std::vector<size_t> FindBadBlocks(std::span<const std::byte> data, const BlockMapFile& file) {
+			std::vector<size_t> badBlocks;
+
+			for (size_t i = 0; i < file.BlockHashes.size(); ++i) {
+				const uint64_t offset = i * BLOCK_SIZE;
+				if (offset > data.size()) {
+					badBlocks.push_back(i);
+					continue;
+				}
+
+				auto block = data.subspan(offset, std::min<uint64_t>(BLOCK_SIZE, data.size() - offset));
+				Sha256::Digest digest = Sha256::Hash(block.data(), block.size());
+
+				auto expected = StringUtils::Base64Decode(file.BlockHashes[i]);
+				if (!expected || !std::ranges::equal(*expected, digest)) {
+					badBlocks.push_back(i);
+				}
+			}
+
+			return badBlocks;
+		}
+
+		// Hardlinked copies of a file are the same data, keyed together with the hash they are expected to have
+		using ShareKey = std::tuple<uint64_t, uint64_t, std::string>;
+
+		struct SharedHashes {
+			std::mutex Mutex;
+			std::map<ShareKey, std::shared_future<std::vector<size_t>>> Results;
+		};
+
+		std::optional<FileIssue> CheckFile(const std::filesystem::path& packageDir, const BlockMapFile& file, SharedHashes& shared) {
+			MappedFile mapped(ResolvePath(packageDir, file));
+			if (!mapped) {
+				return FileIssue{file, FileIssue::Kind::Missing, {}};
+			}
+
+			if (mapped.Size() != file.Size) {
+				return FileIssue{file, FileIssue::Kind::SizeMismatch, {}};
+			}
+
+			const MappedFile::Identity identity = mapped.GetIdentity();
+
+			std::promise<std::vector<size_t>> promise;
+			std::shared_future<std::vector<size_t>> result;
+			bool owner = false;
+			{
+				std::scoped_lock lock(shared.Mutex);
+				auto [it, inserted] = shared.Results.try_emplace({identity.Device, identity.Index, file.FileHash});
+				if (inserted) {
+					it->second = promise.get_future().share();
+					owner = true;
+				}
+				result = it->second;
+			}
+
+			// Whoever sees the data first hashes it, the other links wait for that result instead of reading it again
+			if (owner) {
+				promise.set_value(FindBadBlocks(mapped.Data(), file));
+			}
+
+			const std::vector<size_t>& badBlocks = result.get();
+			if (!badBlocks.empty()) {
+				return FileIssue{file, FileIssue::Kind::HashMismatch, badBlocks};
+			}
+
+			return std::nullopt;
+		}
+	}// namespace
+
+	IntegrityScanner::IntegrityScanner(size_t maxConcurrency) : m_Pool(std::max<size_t>(1, maxConcurrency)) {}
+
+	std::vector<IntegrityReport> IntegrityScanner::Scan(const std::vector<std::filesystem::path>& packageDirs) {
+		SharedHashes shared;
+		std::vector<IntegrityReport> reports(packageDirs.size());
+		std::vector<std::vector<std::future<std::optional<FileIssue>>>> pending(packageDirs.size());
+
+		// Every file of every package goes on the pool up front, so the disk always has reads queued
+		for (size_t i = 0; i < packageDirs.size(); ++i) {
+			reports[i].PackageDir = packageDirs[i];
+
+			auto files = ParseBlockMap(packageDirs[i] / "AppxBlockMap.xml");
+			if (!files) {
+				BlockMapFile blockMap;
+				blockMap.Name = "AppxBlockMap.xml";
+				reports[i].Issues.push_back({std::move(blockMap), FileIssue::Kind::Missing, {}});
+				continue;
+			}
+
+			// Each instance's manifest carries its own identity, it is never what the block map says
+			std::erase_if(*files, IsPerInstanceFile);
+
+			for (auto& file: *files) {
+				reports[i].BytesChecked += file.Size;
+				pending[i].push_back(m_Pool.SubmitTask([dir = packageDirs[i], file = std::move(file), &shared]() {
+					return CheckFile(dir, file, shared);
+				}));
+			}
+		}
+
+		for (size_t i = 0; i < packageDirs.size(); ++i) {
+			for (auto& check: pending[i]) {
+				if (auto issue = check.get()) {
+					reports[i].Issues.push_back(std::move(*issue));
+				}
+			}
+
+			reports[i].FilesChecked = pending[i].size();
+		}
+
+		return reports;
+	}
+
+	IntegrityReport IntegrityScanner::Scan(const std::filesystem::path& packageDir) {
+		return std::move(Scan(std::vector<std::filesystem::path>{packageDir}).front());
+	}
+
+	bool IntegrityScanner::Repair(const IntegrityReport& report, const std::filesystem::path& templateDir) {
+		bool success = true;
+
+		for (const auto& issue: report.Issues) {
+			if (issue.File.Name == "AppxBlockMap.xml") {
+				CoreLogger::Log(LogLevel::ERR, "{} has no block map, update the instance instead", report.PackageDir.string());
+				success = false;
+				continue;
+			}
+
+			// The template's manifest would overwrite the instance's identity
+			if (IsPerInstanceFile(issue.File)) {
+				continue;
+			}
+
+			const std::filesystem::path source = ResolvePath(templateDir, issue.File);
+
+			{
+				MappedFile mapped(source);
+				if (!mapped || mapped.Size() != issue.File.Size || !FindBadBlocks(mapped.Data(), issue.File).empty()) {
+					CoreLogger::Log(LogLevel::ERR, "The template copy of {} does not match either, update the template first", issue.File.Name);
+					success = false;
+					continue;
+				}
+			}
+
+			// Written under a temporary name first, a crash never leaves a half-copied file behind
+			const std::filesystem::path target = report.PackageDir / std::filesystem::relative(source, templateDir);
+			auto temp = target;
+			temp += ".repair";
+
+			std::error_code ec;
+			std::filesystem::create_directories(target.parent_path(), ec);
+			std::filesystem::copy_file(source, temp, std::filesystem::copy_options::overwrite_existing, ec);
+			if (!ec) {
+				std::filesystem::rename(temp, target, ec);
+			}
+
+			if (ec) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to repair {}: {}", target.string(), ec.message());
+				std::filesystem::remove(temp, ec);
+				success = false;
+				continue;
+			}
+
+			CoreLogger::Log(LogLevel::INFO, "Repaired {}", target.string());
+		}
+
+		return success;
+	}
+}// namespace Appx
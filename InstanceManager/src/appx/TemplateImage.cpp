@@ -0,0 +1,367 @@
+#include "appx/TemplateImage.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+
+#include "logging/CoreLogger.hpp"
+#include "utils/filesystem/FS.h"
+#include "utils/threadpool/ThreadPool.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Image layout, all integers little endian:
+//   ImageHeader at offset 0
+//   IndexRecord[EntryCount] at IndexOffset, sorted by path
+//   the paths, '/' separated and relative to the template, at NamesOffset
+//   payloads, each on a PAYLOAD_ALIGNMENT boundary
+namespace Appx {
+	namespace {
+		constexpr std::array<char, 8> IMAGE_MAGIC = {'I', 'M', 'P', 'A', 'C', 'K', '0', '1'};
+		constexpr uint32_t IMAGE_VERSION = 2;
+		constexpr uint32_t DIRECTORY_FLAG = 1;
+		constexpr size_t FILES_PER_TASK = 32;
+
+		struct ImageHeader {
+			std::array<char, 8> Magic;
+			uint32_t Version;
+			uint32_t EntryCount;
+			uint64_t IndexOffset;
+			uint64_t NamesOffset;
+			uint64_t NamesSize;
+			uint64_t ImageSize;
+			uint64_t SourceFingerprint;
+		};
+
+		struct IndexRecord {
+			uint64_t NameOffset;
+			uint64_t DataOffset;
+			uint64_t Size;
+			uint32_t NameLength;
+			uint32_t Flags;
+		};
+
+		static_assert(sizeof(ImageHeader) == 56 && sizeof(IndexRecord) == 32);
+
+		uint64_t AlignUp(uint64_t value) {
+			return (value + TemplateImage::PAYLOAD_ALIGNMENT - 1) & ~(TemplateImage::PAYLOAD_ALIGNMENT - 1);
+		}
+
+		struct SourceEntry {
+			std::string Path;
+			std::filesystem::path Source;
+			uint64_t Size = 0;
+			int64_t WriteTime = 0;
+			bool IsDirectory = false;
+		};
+
+		// Every entry of sourceDir sorted by path, the order the index is written in
+		std::optional<std::vector<SourceEntry>> ReadSource(const std::filesystem::path& sourceDir) {
+			std::vector<SourceEntry> sources;
+
+			std::error_code ec;
+			for (const auto& entry: std::filesystem::recursive_directory_iterator(sourceDir, ec)) {
+				SourceEntry source;
+				source.Path = std::filesystem::relative(entry.path(), sourceDir).generic_string();
+				source.Source = entry.path();
+				source.IsDirectory = entry.is_directory();
+
+				if (!source.IsDirectory) {
+					if (!entry.is_regular_file()) {
+						continue;
+					}
+					source.Size = entry.file_size();
+					source.WriteTime = entry.last_write_time().time_since_epoch().count();
+				}
+
+				sources.push_back(std::move(source));
+			}
+
+			if (ec) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to read {}: {}", sourceDir.string(), ec.message());
+				return std::nullopt;
+			}
+
+			std::ranges::sort(sources, {}, &SourceEntry::Path);
+			return sources;
+		}
+
+		// FNV-1a over every path, size and modification time
+		uint64_t FingerprintOf(const std::vector<SourceEntry>& sources) {
+			uint64_t hash = 0xcbf29ce484222325;
+			auto mix = [&hash](const void* data, size_t size) {
+				for (size_t i = 0; i < size; ++i) {
+					hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 0x100000001b3;
+				}
+			};
+
+			for (const auto& source: sources) {
+				mix(source.Path.data(), source.Path.size() + 1);
+				mix(&source.Size, sizeof(source.Size));
+				mix(&source.WriteTime, sizeof(source.WriteTime));
+			}
+			return hash;
+		}
+	}// namespace
+
+	std::optional<uint64_t> TemplateImage::Fingerprint(const std::filesystem::path& sourceDir) {
+		auto sources = ReadSource(sourceDir);
+		if (!sources) {
+			return std::nullopt;
+		}
+		return FingerprintOf(*sources);
+	}
+
+	bool TemplateImage::Build(const std::filesystem::path& sourceDir, const std::filesystem::path& imagePath) {
+		auto read = ReadSource(sourceDir);
+		if (!read) {
+			return false;
+		}
+		const std::vector<SourceEntry>& sources = *read;
+
+		std::error_code ec;
+		ImageHeader header{};
+		header.Magic = IMAGE_MAGIC;
+		header.Version = IMAGE_VERSION;
+		header.EntryCount = static_cast<uint32_t>(sources.size());
+		header.SourceFingerprint = FingerprintOf(sources);
+		header.IndexOffset = sizeof(ImageHeader);
+		header.NamesOffset = header.IndexOffset + sources.size() * sizeof(IndexRecord);
+
+		std::string names;
+		std::vector<IndexRecord> index;
+		for (const auto& source: sources) {
+			IndexRecord record{};
+			record.NameOffset = names.size();
+			record.NameLength = static_cast<uint32_t>(source.Path.size());
+			record.Size = source.Size;
+			record.Flags = source.IsDirectory ? DIRECTORY_FLAG : 0;
+
+			names += source.Path;
+			index.push_back(record);
+		}
+		header.NamesSize = names.size();
+
+		uint64_t dataOffset = AlignUp(header.NamesOffset + header.NamesSize);
+		for (auto& record: index) {
+			if (record.Flags & DIRECTORY_FLAG) {
+				continue;
+			}
+			record.DataOffset = dataOffset;
+			dataOffset = AlignUp(dataOffset + record.Size);
+		}
+		header.ImageSize = dataOffset;
+
+		// Built next to the old image and swapped in only once it is complete
+		auto tempPath = imagePath;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexRecord)));
+			out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+			std::vector<char> buffer(1 << 20);
+			for (size_t i = 0; i < sources.size() && out; ++i) {
+				if (sources[i].IsDirectory) {
+					continue;
+				}
+
+				out.seekp(static_cast<std::streamoff>(index[i].DataOffset));
+
+				std::ifstream in(sources[i].Source, std::ios::binary);
+				uint64_t remaining = index[i].Size;
+				while (remaining > 0 && in.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(buffer.size(), remaining)))) {
+					out.write(buffer.data(), in.gcount());
+					remaining -= in.gcount();
+				}
+
+				if (remaining > 0) {
+					CoreLogger::Log(LogLevel::ERR, "Failed to read {}", sources[i].Source.string());
+					out.setstate(std::ios::failbit);
+				}
+			}
+
+			if (!out) {
+				out.close();
+				std::filesystem::remove(tempPath, ec);
+				CoreLogger::Log(LogLevel::ERR, "Failed to write {}", tempPath.string());
+				return false;
+			}
+		}
+
+		// Pads the last payload, seeking past the end does not extend the file by itself
+		std::filesystem::resize_file(tempPath, header.ImageSize, ec);
+		FS::SyncFile(tempPath);
+		std::filesystem::rename(tempPath, imagePath, ec);
+		if (ec) {
+			CoreLogger::Log(LogLevel::ERR, "Failed to replace {}: {}", imagePath.string(), ec.message());
+			return false;
+		}
+
+		CoreLogger::Log(LogLevel::INFO, "Packed {} template entries into {}", sources.size(), imagePath.string());
+		return true;
+	}
+
+	std::unique_ptr<TemplateImage> TemplateImage::Open(const std::filesystem::path& imagePath) {
+		std::unique_ptr<TemplateImage> image(new TemplateImage());
+
+		if (!image->m_File.Open(imagePath) || image->m_File.Size() < sizeof(ImageHeader)) {
+			CoreLogger::Log(LogLevel::ERR, "Failed to map {}", imagePath.string());
+			return nullptr;
+		}
+
+		const std::byte* view = image->m_File.Data().data();
+		const uint64_t size = image->m_File.Size();
+
+		ImageHeader header;
+		std::memcpy(&header, view, sizeof(header));
+
+		const uint64_t indexEnd = header.IndexOffset + uint64_t{header.EntryCount} * sizeof(IndexRecord);
+		if (header.Magic != IMAGE_MAGIC || header.Version != IMAGE_VERSION || header.ImageSize != size ||
+		    indexEnd > size || header.NamesOffset + header.NamesSize > size) {
+			CoreLogger::Log(LogLevel::ERR, "{} is not a valid template image", imagePath.string());
+			return nullptr;
+		}
+
+		image->m_SourceFingerprint = header.SourceFingerprint;
+
+		const char* names = reinterpret_cast<const char*>(view + header.NamesOffset);
+		image->m_Entries.reserve(header.EntryCount);
+
+		for (uint32_t i = 0; i < header.EntryCount; ++i) {
+			IndexRecord record;
+			std::memcpy(&record, view + header.IndexOffset + i * sizeof(IndexRecord), sizeof(record));
+
+			if (record.NameOffset + record.NameLength > header.NamesSize || record.DataOffset + record.Size > size) {
+				CoreLogger::Log(LogLevel::ERR, "{} has a corrupt index", imagePath.string());
+				return nullptr;
+			}
+
+			Entry entry;
+			entry.Path = std::string_view(names + record.NameOffset, record.NameLength);
+			entry.Offset = record.DataOffset;
+			entry.Size = record.Size;
+			entry.IsDirectory = (record.Flags & DIRECTORY_FLAG) != 0;
+			image->m_Entries.push_back(entry);
+		}
+
+		return image;
+	}
+
+	std::optional<TemplateImage::Entry> TemplateImage::Find(std::string_view path) const {
+		auto it = std::ranges::lower_bound(m_Entries, path, {}, &Entry::Path);
+		if (it == m_Entries.end() || it->Path != path) {
+			return std::nullopt;
+		}
+		return *it;
+	}
+
+	std::span<const std::byte> TemplateImage::Data(const Entry& entry) const {
+		return m_File.Data().subspan(entry.Offset, entry.Size);
+	}
+
+	bool TemplateImage::WriteEntry(const Entry& entry, const std::filesystem::path& target) const {
+#ifdef _WIN32
+		HANDLE file = CreateFileW(target.wstring().c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		// The payload goes from the mapped view straight to the file, there is no intermediate buffer
+		const std::byte* data = m_File.Data().data() + entry.Offset;
+		uint64_t remaining = entry.Size;
+		bool written = true;
+
+		while (remaining > 0 && written) {
+			DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(remaining, 1u << 30));
+			DWORD bytesWritten = 0;
+			written = WriteFile(file, data, chunk, &bytesWritten, NULL) && bytesWritten == chunk;
+			data += chunk;
+			remaining -= chunk;
+		}
+
+		CloseHandle(file);
+		return written;
+#else
+		int out = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (out < 0) {
+			return false;
+		}
+
+		// copy_file_range lets the kernel move the payload, or share its extents on filesystems that support reflinks
+		off64_t offset = static_cast<off64_t>(entry.Offset);
+		uint64_t remaining = entry.Size;
+		while (remaining > 0) {
+			ssize_t copied = copy_file_range(m_File.Descriptor(), &offset, out, nullptr, remaining, 0);
+			if (copied <= 0) {
+				break;
+			}
+			remaining -= static_cast<uint64_t>(copied);
+		}
+
+		// Falls back to writing out of the mapping when the kernel cannot copy between these filesystems
+		const std::byte* data = m_File.Data().data() + entry.Offset + (entry.Size - remaining);
+		while (remaining > 0) {
+			ssize_t written = write(out, data, remaining);
+			if (written <= 0) {
+				break;
+			}
+			data += written;
+			remaining -= static_cast<uint64_t>(written);
+		}
+
+		close(out);
+		return remaining == 0;
+#endif
+	}
+
+	bool TemplateImage::Materialize(const std::filesystem::path& dst, size_t maxConcurrency) const {
+		std::error_code ec;
+		std::filesystem::create_directories(dst, ec);
+
+		// The index is sorted, so every directory comes before anything inside it
+		std::vector<const Entry*> files;
+		for (const auto& entry: m_Entries) {
+			if (entry.IsDirectory) {
+				std::filesystem::create_directories(dst / entry.Path, ec);
+			} else {
+				files.push_back(&entry);
+			}
+		}
+
+		ThreadPool pool(std::max<size_t>(1, maxConcurrency));
+		std::vector<std::future<bool>> results;
+
+		for (size_t start = 0; start < files.size(); start += FILES_PER_TASK) {
+			std::span<const Entry* const> batch(files.data() + start, std::min(FILES_PER_TASK, files.size() - start));
+
+			results.push_back(pool.SubmitTask([this, batch, &dst]() {
+				bool success = true;
+				for (const Entry* entry: batch) {
+					if (!WriteEntry(*entry, dst / entry->Path)) {
+						CoreLogger::Log(LogLevel::ERR, "Failed to write {}", (dst / entry->Path).string());
+						success = false;
+					}
+				}
+				return success;
+			}));
+		}
+
+		bool success = true;
+		for (auto& result: results) {
+			success &= result.get();
+		}
+
+		return success;
+	}
+}// namespace Appx
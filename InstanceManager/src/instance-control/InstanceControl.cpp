@@ -4,7 +4,11 @@
 
 #include <fstream>
 
+#include "appx/TemplateImage.h"
+#include "config/Config.hpp"
+#include "logging/CoreLogger.hpp"
 #include "utils/filesystem/FS.h"
+#include "utils/threadpool/Task.hpp"
 
 InstanceControl& GetPrivateInstance() {
 	static InstanceControl instance;
@@ -14,13 +18,17 @@ InstanceControl& GetPrivateInstance() {
 InstanceControl& g_InstanceControl = GetPrivateInstance();
 
 bool InstanceControl::LaunchInstance(const std::string& username, const std::string& placeid, const std::string& linkcode) {
+	std::unique_lock lock(m_InstancesMutex);
 	auto it = m_Instances.find(username);
 	Roblox::Instance& instance = std::get<0>(it->second);
+	lock.unlock();
+
 	auto manager = std::make_unique<Manager>(instance, username, placeid, linkcode);
 	if (!manager->start()) {
 		return false;
 	}
 
+	lock.lock();
 	m_LaunchedInstances[username] = std::move(manager);
 	std::get<1>(it->second) = IM_COL32(40, 170, 40, 255);
 
@@ -28,6 +36,7 @@ bool InstanceControl::LaunchInstance(const std::string& username, const std::str
 }
 
 bool InstanceControl::TerminateInstance(const std::string& username) {
+	std::scoped_lock lock(m_InstancesMutex);
 	auto it = m_Instances.find(username);
 	if (m_LaunchedInstances.find(username) == m_LaunchedInstances.end()) {
 		for (auto& group: m_Groups) {
@@ -44,6 +53,7 @@ bool InstanceControl::TerminateInstance(const std::string& username) {
 }
 
 bool InstanceControl::IsInstanceRunning(const std::string& username) {
+	std::scoped_lock lock(m_InstancesMutex);
 	if (m_LaunchedInstances.find(username) == m_LaunchedInstances.end() || OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, m_LaunchedInstances[username]->GetPID()) == NULL) {
 		return false;
 	}
@@ -59,17 +69,20 @@ void InstanceControl::TerminateGroup(const std::string& groupname) {
 
 	std::vector<std::string> accs = it->second->GetAccounts();
 
+	std::unique_lock lock(m_InstancesMutex);
 	for (const auto& username: accs) {
 		auto instanceIt = m_Instances.find(username);
 		if (instanceIt != m_Instances.end()) {
 			std::get<1>(instanceIt->second) = IM_COL32(77, 77, 77, 255);
 		}
 	}
+	lock.unlock();
 
 	m_Groups.erase(it);
 }
 
 std::vector<std::string> InstanceControl::GetInstanceNames() const {
+	std::scoped_lock lock(m_InstancesMutex);
 	std::vector<std::string> names;
 	names.reserve(m_Instances.size());
 
@@ -82,32 +95,119 @@ std::vector<std::string> InstanceControl::GetInstanceNames() const {
 }
 
 bool InstanceControl::CreateInstance(const std::string& username) {
-	std::filesystem::path path(fmt::format("Instances\\{}", username));
-	std::filesystem::create_directory(path);
-	FS::CopyDirectory("Template", path);
+	return CreateInstances({username});
+}
 
-	//std::string manifestPath = path + "\\AppxManifest.xml";
-	std::filesystem::path manifestPath = path / "AppxManifest.xml";
-	Utils::ModifyAppxManifest(manifestPath, username);
+bool InstanceControl::CreateInstances(const std::vector<std::string>& usernames) {
+	// Everything but the files that get patched or replaced per instance is shared with the template through hardlinks
+	static const std::vector<std::filesystem::path> privateFiles = {
+	        "AppxManifest.xml",
+	        "Windows10Universal.exe",
+	        std::filesystem::path("Assets") / "CrashHandler.exe",
+	};
+
+	const std::string cloneMode = Config::getInstance().GetStringForKey("cloneMode").value_or("hardlink");
+
+	// Image mode writes every instance out of one mapped file. The image is packed again when it is missing or the
+	// folder changed since it was packed.
+	std::unique_ptr<Appx::TemplateImage> image;
+	if (cloneMode == "image") {
+		const auto imagePath = Appx::TemplateImage::ImagePathFor("Template");
+		const auto fingerprint = Appx::TemplateImage::Fingerprint("Template");
+
+		if (std::filesystem::exists(imagePath)) {
+			image = Appx::TemplateImage::Open(imagePath);
+		}
 
-	std::string abs_path = std::filesystem::absolute(manifestPath).string();
-	Native::InstallUWPApp(winrt::to_hstring(abs_path));
+		if (!image || image->SourceFingerprint() != fingerprint) {
+			if (image) {
+				CoreLogger::Log(LogLevel::INFO, "Template changed since it was packed, packing it again");
+			}
 
-	std::set<std::string> oldInstances;
-	for (const auto& pair: m_Instances)
-		oldInstances.insert(pair.first);
+			image.reset();
+			if (Appx::TemplateImage::Build("Template", imagePath)) {
+				image = Appx::TemplateImage::Open(imagePath);
+			}
+		}
 
-	m_Instances = Roblox::ProcessRobloxPackages();
+		if (!image) {
+			CoreLogger::Log(LogLevel::WARNING, "Template image unavailable, creating instances from the folder");
+		}
+	}
 
-	std::vector<std::string> newInstances;
-	for (const auto& pair: m_Instances) {
-		if (oldInstances.find(pair.first) == oldInstances.end())
-			newInstances.push_back(pair.first);
+	// Each instance is materialized then patched as soon as its files are there, independent of the others. The batch
+	// is registered in one call once every manifest is ready, then the instance list is refreshed.
+	ThreadPool pool(std::clamp<size_t>(usernames.size(), 1, 4));
+	std::vector<Task<std::string>> prepared;
+
+	for (const auto& username: usernames) {
+		auto materialized = Tasks::Run(pool, [username, &cloneMode, &image]() -> std::filesystem::path {
+			std::filesystem::path path(fmt::format("Instances\\{}", username));
+			std::filesystem::create_directory(path);
+
+			bool ok;
+			if (image) {
+				ok = image->Materialize(path);
+			} else if (cloneMode == "copy") {
+				ok = FS::CopyDirectory("Template", path);
+			} else {
+				ok = FS::CloneDirectory("Template", path, privateFiles);
+			}
+
+			if (!ok) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to create the files of {}", username);
+				return {};
+			}
+			return path;
+		});
+
+		prepared.push_back(materialized.Then([username](const std::filesystem::path& path) -> std::string {
+			if (path.empty()) {
+				return {};
+			}
+
+			std::filesystem::path manifestPath = path / "AppxManifest.xml";
+			Utils::ModifyAppxManifest(manifestPath, username);
+
+			return std::filesystem::absolute(manifestPath).string();
+		}));
 	}
 
-	std::thread(&InstanceControl::AnimateThread, this, newInstances).detach();
+	auto registered = Tasks::WhenAll(pool, std::move(prepared)).Then([](const std::vector<std::string>& paths) {
+		std::vector<winrt::hstring> manifests;
+		for (const auto& path: paths) {
+			if (!path.empty()) {
+				manifests.push_back(winrt::to_hstring(path));
+			}
+		}
 
-	return true;
+		std::vector<bool> registered = Native::InstallUWPApps(manifests);
+		return std::make_pair(manifests.size(), std::ranges::all_of(registered, std::identity{}));
+	});
+
+	// One package enumeration for the whole batch. Merged in rather than replacing the map, other lanes may hold
+	// references to instances that are still installed.
+	auto refreshed = registered.Then([this](const std::pair<size_t, bool>&) {
+		auto packages = Roblox::ProcessRobloxPackages();
+
+		std::vector<std::string> newInstances;
+		{
+			std::scoped_lock lock(m_InstancesMutex);
+			std::erase_if(m_Instances, [&packages](const auto& pair) { return !packages.contains(pair.first); });
+
+			for (auto& [name, entry]: packages) {
+				if (m_Instances.try_emplace(name, std::move(entry)).second)
+					newInstances.push_back(name);
+			}
+		}
+
+		std::thread(&InstanceControl::AnimateThread, this, newInstances).detach();
+	});
+
+	refreshed.Get();
+
+	const auto& [created, allRegistered] = registered.Get();
+	return created == usernames.size() && allRegistered;
 }
 
 
@@ -115,14 +215,6 @@ void InstanceControl::AnimateThread(const std::vector<std::string>& newInstances
 	auto startTime = std::chrono::high_resolution_clock::now();
 	double duration = 2.0;
 
-	std::vector<std::reference_wrapper<ImU32>> instanceColors;
-	for (const auto& instanceName: newInstances) {
-		auto it = m_Instances.find(instanceName);
-		if (it != m_Instances.end()) {
-			instanceColors.emplace_back(std::get<1>(it->second));
-		}
-	}
-
 	constexpr static auto sine_period = 3 * 3.14159265358979323846;
 	constexpr static auto base_color = 77;
 	constexpr static auto offset_color = 255 - 77;
@@ -138,8 +230,15 @@ void InstanceControl::AnimateThread(const std::vector<std::string>& newInstances
 		double y = std::abs(sin(sine_period * (elapsed / duration)));
 		ImU32 greenValue = base_color + offset_color * y;
 
-		for (auto& colorRef: instanceColors) {
-			colorRef.get() = IM_COL32(base_color, greenValue, base_color, 0xFF);
+		// Looked up again every frame, a create or delete on another lane may have dropped the entry meanwhile
+		{
+			std::scoped_lock lock(m_InstancesMutex);
+			for (const auto& instanceName: newInstances) {
+				auto it = m_Instances.find(instanceName);
+				if (it != m_Instances.end()) {
+					std::get<1>(it->second) = IM_COL32(base_color, greenValue, base_color, 0xFF);
+				}
+			}
 		}
 
 		Utils::SleepFor(std::chrono::milliseconds(wait_period));
@@ -147,12 +246,17 @@ void InstanceControl::AnimateThread(const std::vector<std::string>& newInstances
 }
 
 void InstanceControl::DeleteInstance(const std::string& name) {
-	Roblox::NukeInstance(std::get<Roblox::Instance>(m_Instances[name]).PackageFullName, std::get<Roblox::Instance>(m_Instances[name]).InstallLocation);
+	std::unique_lock lock(m_InstancesMutex);
+	const Roblox::Instance instance = std::get<Roblox::Instance>(m_Instances[name]);
+	lock.unlock();
+
+	Roblox::NukeInstance(instance.PackageFullName, instance.InstallLocation);
 }
 
 void InstanceControl::CreateGroup(const GroupCreationInfo& info) {
 	std::unordered_map<std::string, std::unique_ptr<Manager>> managers;
 
+	std::unique_lock lock(m_InstancesMutex);
 	for (const auto& username: info.usernames) {
 		auto it = m_Instances.find(username);
 		if (it != m_Instances.end()) {
@@ -162,6 +266,7 @@ void InstanceControl::CreateGroup(const GroupCreationInfo& info) {
 			std::get<1>(it->second) = info.color;
 		}
 	}
+	lock.unlock();
 
 	auto [group_it, inserted] = m_Groups.emplace(info.groupname, std::make_unique<Group>(std::move(managers), info.relaunchinterval, info.launchdelay, info.injectdelay, info.dllpath, info.mode, info.method));
 
@@ -176,5 +281,13 @@ Manager& InstanceControl::GetManager(const std::string& username) {
 }
 
 const Roblox::Instance& InstanceControl::GetInstance(const std::string& username) {
+	std::scoped_lock lock(m_InstancesMutex);
 	return std::get<Roblox::Instance>(m_Instances[username]);
 }
+
+// The UI can still list an instance for a frame after a create or delete dropped it here
+ImU32 InstanceControl::GetColor(const std::string& username) {
+	std::scoped_lock lock(m_InstancesMutex);
+	auto it = m_Instances.find(username);
+	return it != m_Instances.end() ? std::get<ImU32>(it->second) : IM_COL32(77, 77, 77, 255);
+}
@@ -128,6 +128,43 @@ namespace Native {
 	}
 
 
+	// Starts every registration before waiting on any of them, so the deployment service gets the whole batch at once
+	std::vector<bool> InstallUWPApps(const std::vector<winrt::hstring>& packagePaths) {
+		using namespace winrt::Windows::Management::Deployment;
+		using DeploymentOperation = winrt::Windows::Foundation::IAsyncOperationWithProgress<DeploymentResult, DeploymentProgress>;
+
+		PackageManager packageManager;
+		std::vector<DeploymentOperation> operations;
+		std::vector<bool> results(packagePaths.size(), false);
+
+		for (const auto& packagePath: packagePaths) {
+			try {
+				operations.push_back(packageManager.RegisterPackageAsync(winrt::Windows::Foundation::Uri{packagePath}, nullptr, DeploymentOptions::DevelopmentMode));
+			} catch (const winrt::hresult_error& ex) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to register {}: {}", winrt::to_string(packagePath), winrt::to_string(ex.message()));
+				operations.push_back(nullptr);
+			}
+		}
+
+		for (size_t i = 0; i < operations.size(); ++i) {
+			if (!operations[i]) {
+				continue;
+			}
+
+			try {
+				const DeploymentResult& result = operations[i].get();
+				results[i] = operations[i].Status() == winrt::Windows::Foundation::AsyncStatus::Completed;
+				if (!results[i]) {
+					CoreLogger::Log(LogLevel::ERR, "Failed to register {}: {}", winrt::to_string(packagePaths[i]), winrt::to_string(result.ErrorText()));
+				}
+			} catch (const winrt::hresult_error& ex) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to register {}: {}", winrt::to_string(packagePaths[i]), winrt::to_string(ex.message()));
+			}
+		}
+
+		return results;
+	}
+
 	bool RemoveUWPApp(const winrt::hstring& packageFullName) {
 		try {
 			winrt::Windows::Management::Deployment::PackageManager packageManager;
@@ -314,32 +351,6 @@ namespace Native {
 		return false;
 	}
 
-	std::string SearchEntireProcessMemory(HANDLE pHandle, const unsigned char* pattern, size_t patternSize, ExtractFunction extractFunction) {
-		uintptr_t address = 0;
-		MEMORY_BASIC_INFORMATION mbi = {};
-
-		while (VirtualQueryEx(pHandle, reinterpret_cast<void*>(address), &mbi, sizeof(mbi))) {
-			if (IsReadableMemory(mbi)) {
-				std::vector<unsigned char> buffer(mbi.RegionSize);
-
-				if (ReadProcessMemory(pHandle, reinterpret_cast<void*>(address), buffer.data(), mbi.RegionSize, nullptr)) {
-					uintptr_t offset = Utils::BoyerMooreHorspool(pattern, patternSize, buffer.data(), mbi.RegionSize);
-					if (offset != 0) {
-						std::string value = extractFunction(buffer.data() + offset + patternSize, mbi.RegionSize - offset - patternSize);
-						if (!value.empty()) {
-							return value;
-						}
-					}
-				}
-			}
-
-			// Move to the next memory region
-			address += mbi.RegionSize;
-		}
-
-		return "";
-	}
-
 	std::optional<DWORD> LaunchAppWithProtocol(const std::string& appName, const std::string& AppID, const std::string& protocolString) {
 		winrt::hstring protocolURI = winrt::to_hstring(protocolString);
 		winrt::hstring hAppID = winrt::to_hstring(AppID);
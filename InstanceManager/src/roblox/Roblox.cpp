@@ -1,7 +1,10 @@
 #include "roblox/Roblox.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <regex>
+#include <tuple>
 #include <variant>
 
 #include "cpr/cpr.h"
@@ -9,19 +12,26 @@
 #include "logging/CoreLogger.hpp"
 #include "native/Native.h"
 #include "nlohmann/json.hpp"
+#include "scanner/FixedPattern.h"
+#include "scanner/IncrementalScan.h"
 #include "tinyxml2.h"
 #include "utils/Utils.hpp"
+#include "utils/filesystem/DeletionService.h"
 #include "utils/filesystem/FS.h"
 
 #define USER_AGENT "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/116.0.0.0 Safari/537.36"
 
 namespace Roblox {
+	// Code values tried per login before giving up, every attempt is a request to Roblox
+	constexpr size_t MAX_CODE_ATTEMPTS = 5;
+	// How long to wait for the code to show up in memory after the login screen opens, and how often to look
+	constexpr std::chrono::milliseconds CODE_WAIT(5000);
+	constexpr std::chrono::milliseconds CODE_POLL_INTERVAL(250);
+
 	void NukeInstance(const std::string& packagefullname, const std::string& path) {
 		Native::RemoveUWPApp(winrt::to_hstring(packagefullname));
 
-		std::thread([path]() {
-			FS::RemovePath(path);
-		}).detach();
+		DeletionService::GetInstance().Enqueue(path);
 	}
 
 	Roblox::Instance createRobloxInstance(const winrt::Windows::ApplicationModel::Package& package) {
@@ -207,19 +217,48 @@ namespace Roblox {
 		return code;
 	}
 
-	std::string FindCodeValue(HANDLE pHandle) {
-		// First pattern: key=???????-????-????-????-????????????&code=
-		auto pattern1 = Utils::ParsePattern("6B 65 79 3D ?? ?? ?? ?? ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 26 63 6F 64 65 3D");
-		std::string codeValue = Native::SearchEntireProcessMemory(pHandle, pattern1.data(), pattern1.size(), Roblox::ExtractCode);
-
-		if (!codeValue.empty()) return codeValue;
+	std::vector<std::string> FindCodeValues(HANDLE pHandle, std::chrono::milliseconds timeout) {
+		using namespace Scanner::Literals;
+
+		static const std::vector<Scanner::Pattern> patterns = {
+		        // key=???????-????-????-????-????????????&code=
+		        "6B 65 79 3D ?? ?? ?? ?? ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? 2D ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 26 63 6F 64 65 3D"_pattern,
+		        // "code":"
+		        "22 63 6F 64 65 22 3A 22"_pattern,
+		};
+
+		auto memory = Scanner::ProcessMemory::FromHandle(pHandle);
+		Scanner::IncrementalScan scan(*memory, patterns);
+
+		// One pass collects every candidate, so a rejected code doesn't mean scanning the process again
+		std::vector<std::tuple<size_t, uintptr_t, std::string>> candidates;
+		auto collect = [&](const Scanner::MemoryMatch& match) {
+			const size_t patternSize = patterns[match.PatternIndex].Size();
+			std::string code = Roblox::ExtractCode(match.Data.data() + patternSize, match.Data.size() - patternSize);
+			if (!code.empty()) {
+				candidates.emplace_back(match.PatternIndex, match.Address, std::move(code));
+			}
+			return true;
+		};
+
+		// Passes after the first only look at memory written since the one before
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		scan.Next(collect);
+		while (candidates.empty() && std::chrono::steady_clock::now() < deadline) {
+			Utils::SleepFor(CODE_POLL_INTERVAL);
+			scan.Next(collect);
+		}
 
-		// Second pattern: "\"code\":\""
-		unsigned char pattern2[] = {0x22, 0x63, 0x6F, 0x64, 0x65, 0x22, 0x3A, 0x22};
-		size_t patternSize2 = sizeof(pattern2) / sizeof(unsigned char);
-		codeValue = Native::SearchEntireProcessMemory(pHandle, pattern2, patternSize2, Roblox::ExtractCode);
+		// The key=...&code= form is more reliable than "code":", each in address order
+		std::ranges::sort(candidates);
 
-		return codeValue;
+		std::vector<std::string> codes;
+		for (auto& [patternIndex, address, code]: candidates) {
+			if (std::ranges::find(codes, code) == codes.end()) {
+				codes.push_back(std::move(code));
+			}
+		}
+		return codes;
 	}
 
 	std::vector<std::string> GetNewInstances(const std::vector<std::string>& old_instances) {
@@ -241,14 +280,29 @@ namespace Roblox {
 	void HandleCodeValidation(DWORD pid, const std::string& cookie) {
 		HANDLE pHandle = OpenProcess(PROCESS_ALL_ACCESS, FALSE, pid);
 
-		std::string codeValue = Roblox::FindCodeValue(pHandle);
+		std::vector<std::string> codes = Roblox::FindCodeValues(pHandle, CODE_WAIT);
 
-		if (codeValue.empty()) {
+		if (codes.empty()) {
 			CoreLogger::Log(LogLevel::INFO, "Code value not found");
-		} else {
-			CoreLogger::Log(LogLevel::INFO, "Code value found: {}", codeValue);
-			Roblox::EnterCode(codeValue, cookie);
-			Roblox::ValidateCode(codeValue, cookie);
+			return;
 		}
+
+		const size_t attempts = std::min(codes.size(), MAX_CODE_ATTEMPTS);
+		for (size_t i = 0; i < attempts; ++i) {
+			CoreLogger::Log(LogLevel::INFO, "Code value found: {}", codes[i]);
+
+			// A code Roblox doesn't know comes back with an errors array, the next candidate gets a try. Any other reply,
+			// an empty one included, goes on to validation as it always did.
+			nlohmann::json response = nlohmann::json::parse(Roblox::EnterCode(codes[i], cookie), nullptr, false);
+			if (response.is_object() && response.contains("errors") && response["errors"].is_array()) {
+				CoreLogger::Log(LogLevel::WARNING, "Code {} was rejected", codes[i]);
+				continue;
+			}
+
+			Roblox::ValidateCode(codes[i], cookie);
+			return;
+		}
+
+		CoreLogger::Log(LogLevel::ERR, "None of the {} code values found were accepted", attempts);
 	}
 }// namespace Roblox
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "scanner/IncrementalScan.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <future>
+#include <mutex>
+
+#include "scanner/MemoryScan.h"
+#include "scanner/RegionCache.h"
+#include "utils/threadpool/ThreadPool.hpp"
+
+namespace Scanner {
+	namespace {
+		constexpr size_t PAGE_BYTES = ProcessMemory::PAGE_BYTES;
+		// Stands in for the hash of a page that couldn't be read
+		constexpr uint64_t UNREADABLE_PAGE = 0;
+
+		// Four independent multiply-rotate lanes, a page hashes at close to memory speed. Only compared against the
+		// same page's previous hash, so it doesn't have to resist anything but accidental collisions.
+		uint64_t HashPage(const uint8_t* page, size_t size) {
+			constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+			constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+			uint64_t lanes[4] = {PRIME_1, PRIME_2, PRIME_1 ^ PRIME_2, ~PRIME_1};
+			size_t i = 0;
+			for (; i + 32 <= size; i += 32) {
+				for (size_t lane = 0; lane < 4; ++lane) {
+					uint64_t word;
+					std::memcpy(&word, page + i + lane * 8, sizeof(word));
+					lanes[lane] = std::rotl(lanes[lane] ^ (word * PRIME_2), 31) * PRIME_1;
+				}
+			}
+
+			uint64_t hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+			for (; i < size; ++i) {
+				hash = (hash ^ page[i]) * PRIME_1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= PRIME_2;
+			hash ^= hash >> 29;
+			return hash == UNREADABLE_PAGE ? 1 : hash;
+		}
+
+		bool AnyChanged(const std::vector<bool>& changed, size_t first, size_t last) {
+			for (size_t page = first; page <= last && page < changed.size(); ++page) {
+				if (changed[page]) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}// namespace
+
+	IncrementalScan::IncrementalScan(const ProcessMemory& memory, const std::vector<Pattern>& patterns) : m_Memory(memory) {
+		for (const auto& pattern: patterns) {
+			m_Patterns.Add(pattern);
+		}
+	}
+
+	std::vector<std::vector<uint64_t>> IncrementalScan::HashPages(const std::vector<MemoryRegion>& regions) const {
+		std::vector<std::vector<uint64_t>> hashes(regions.size());
+		std::vector<std::future<void>> tasks;
+
+		for (size_t i = 0; i < regions.size(); ++i) {
+			hashes[i].assign(regions[i].Size / PAGE_BYTES, UNREADABLE_PAGE);
+
+			// Every task fills its own slice of the hashes
+			for (size_t offset = 0; offset < regions[i].Size; offset += MemoryScan::CHUNK_SIZE) {
+				const size_t size = std::min(MemoryScan::CHUNK_SIZE, regions[i].Size - offset);
+				uint64_t* slice = hashes[i].data() + offset / PAGE_BYTES;
+
+				tasks.push_back(MemoryScan::Pool().SubmitTask([this, base = regions[i].Base + offset, size, slice]() {
+					thread_local std::vector<uint8_t> buffer;
+					if (buffer.size() < size) {
+						buffer.resize(size);
+					}
+
+					const size_t bytesRead = m_Memory.Read(base, buffer.data(), size);
+					for (size_t page = 0; (page + 1) * PAGE_BYTES <= bytesRead; ++page) {
+						slice[page] = HashPage(buffer.data() + page * PAGE_BYTES, PAGE_BYTES);
+					}
+				}));
+			}
+		}
+
+		for (auto& task: tasks) {
+			task.get();
+		}
+
+		return hashes;
+	}
+
+	bool IncrementalScan::Next(const MemoryMatchCallback& onMatch) {
+		// The first pass starts from the layout cached for this process, later ones read it again, since memory
+		// allocated in the meantime is where a new match would be. Either way the cache stays current for the next scan.
+		RegionCache& cache = RegionCache::GetInstance();
+		if (m_Passes++ > 0) {
+			cache.Refresh(m_Memory);
+		}
+		std::vector<MemoryRegion> regions = cache.Get(m_Memory).Regions;
+
+		// Which pages of every region need a scan this pass, all of them for a region that is new or changed size
+		std::unordered_map<uintptr_t, std::vector<bool>> changed;
+		for (const auto& region: regions) {
+			auto previous = m_Regions.find(region.Base);
+			const bool known = previous != m_Regions.end() && previous->second.Size == region.Size;
+
+			std::vector<bool>& pages = changed[region.Base];
+			if (!known || !m_Tracking || !m_Memory.WrittenPages(region.Base, region.Size, pages)) {
+				pages.assign(region.Size / PAGE_BYTES, true);
+			}
+		}
+
+		// A new interval starts before anything is read, a write that lands during the scan shows up next pass
+		m_Tracking = m_Memory.ResetWriteTracking();
+
+		std::unordered_map<uintptr_t, TrackedRegion> tracked;
+		if (m_Tracking) {
+			for (const auto& region: regions) {
+				tracked[region.Base].Size = region.Size;
+			}
+		} else {
+			std::vector<std::vector<uint64_t>> hashes = HashPages(regions);
+
+			for (size_t i = 0; i < regions.size(); ++i) {
+				auto previous = m_Regions.find(regions[i].Base);
+				if (previous != m_Regions.end() && previous->second.Size == regions[i].Size && previous->second.PageHashes.size() == hashes[i].size()) {
+					std::vector<bool>& pages = changed[regions[i].Base];
+					for (size_t page = 0; page < pages.size(); ++page) {
+						pages[page] = previous->second.PageHashes[page] != hashes[i][page];
+					}
+				}
+
+				tracked[regions[i].Base] = TrackedRegion{regions[i].Size, std::move(hashes[i])};
+			}
+		}
+		m_Regions = std::move(tracked);
+
+		// Each run of changed pages is scanned with enough of the memory before it for a match that starts earlier
+		// and runs into the changed part
+		const size_t lookBehind = m_Patterns.MaxPatternSize() - 1;
+		std::vector<ScanRange> ranges;
+		m_LastScannedBytes = 0;
+
+		for (const auto& region: regions) {
+			const std::vector<bool>& pages = changed[region.Base];
+			for (size_t page = 0; page < pages.size();) {
+				if (!pages[page]) {
+					++page;
+					continue;
+				}
+
+				const size_t first = page;
+				while (page < pages.size() && pages[page]) {
+					++page;
+				}
+
+				const uintptr_t runStart = region.Base + first * PAGE_BYTES;
+				const uintptr_t begin = runStart - std::min<uintptr_t>(lookBehind, runStart - region.Base);
+				ranges.push_back({region, begin, region.Base + page * PAGE_BYTES - begin});
+				m_LastScannedBytes += ranges.back().Size;
+			}
+		}
+
+		if (ranges.empty() || m_Patterns.Count() == 0) {
+			return true;
+		}
+
+		std::mutex callbackMutex;
+		MemoryScan scan(m_Memory, m_Patterns, [&](const MemoryMatch& match) {
+			// The look-behind finds matches that were there, unchanged, in the previous pass as well
+			const size_t first = (match.Address - match.Region.Base) / PAGE_BYTES;
+			const size_t last = (match.Address + m_Patterns.Get(match.PatternIndex).Size() - 1 - match.Region.Base) / PAGE_BYTES;
+			if (!AnyChanged(changed.at(match.Region.Base), first, last)) {
+				return;
+			}
+
+			std::scoped_lock lock(callbackMutex);
+			if (!scan.Stopped() && !onMatch(match)) {
+				scan.Stop();
+			}
+		});
+
+		scan.Run(ranges);
+		return !scan.Stopped();
+	}
+}// namespace Scanner
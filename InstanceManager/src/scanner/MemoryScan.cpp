@@ -0,0 +1,163 @@
+#include "scanner/MemoryScan.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "utils/threadpool/ThreadPool.hpp"
+
+namespace Scanner {
+	MemoryScan::MemoryScan(const ProcessMemory& memory, const PatternSet& patterns, MatchHandler onMatch)
+	    : m_Memory(memory), m_Patterns(patterns), m_OnMatch(std::move(onMatch)), m_Overlap(patterns.MaxPatternSize() - 1 + EXTRACT_SLACK) {}
+
+	ThreadPool& MemoryScan::Pool() {
+		static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+		return pool;
+	}
+
+	void MemoryScan::Run(const std::vector<MemoryRegion>& regions) {
+		std::vector<ScanRange> ranges;
+		ranges.reserve(regions.size());
+		for (const auto& region: regions) {
+			ranges.push_back({region, region.Base, region.Size});
+		}
+		Run(ranges);
+	}
+
+	void MemoryScan::Run(const std::vector<ScanRange>& ranges) {
+		std::vector<std::future<void>> tasks;
+		std::vector<ScanRange> batch;
+		size_t batchBytes = 0;
+
+		auto flushBatch = [&]() {
+			if (!batch.empty()) {
+				tasks.push_back(Pool().SubmitTask([this, ranges = std::move(batch)]() { ScanBatch(ranges); }));
+				batch.clear();
+				batchBytes = 0;
+			}
+		};
+
+		for (const auto& range: ranges) {
+			if (range.Size <= RegionReader::DEFAULT_WINDOW_SIZE) {
+				if (batchBytes + range.Size > CHUNK_SIZE) {
+					flushBatch();
+				}
+				batch.push_back(range);
+				batchBytes += range.Size;
+				continue;
+			}
+
+			flushBatch();
+			for (size_t offset = 0; offset < range.Size; offset += CHUNK_SIZE) {
+				tasks.push_back(Pool().SubmitTask([this, range, offset]() {
+					ScanChunk(range.Region, range.Begin + offset, std::min(CHUNK_SIZE, range.Size - offset));
+				}));
+			}
+		}
+		flushBatch();
+
+		for (auto& task: tasks) {
+			task.get();
+		}
+	}
+
+	void MemoryScan::LowerCutoff(uintptr_t address) {
+		uintptr_t current = m_Cutoff.load(std::memory_order_relaxed);
+		while (address < current && !m_Cutoff.compare_exchange_weak(current, address, std::memory_order_relaxed)) {
+		}
+	}
+
+	bool MemoryScan::Visit(const RegionReader::Window& window, const MemoryRegion& region) {
+		m_Patterns.Scan(window.Data, [&](const PatternMatch& match) {
+			if (match.Offset >= window.Owned) {
+				return true;
+			}
+
+			const uintptr_t address = window.Address + match.Offset;
+			if (!PastCutoff(address)) {
+				m_OnMatch(MemoryMatch{match.PatternIndex, address, region, window.Data.subspan(match.Offset)});
+			}
+
+			// Matches are reported in the order they end. Once one ends a whole pattern length past the cutoff,
+			// nothing reported after it can start below the cutoff.
+			const uintptr_t end = address + m_Patterns.Get(match.PatternIndex).Size();
+			return !PastCutoff(end - std::min<uintptr_t>(end, m_Patterns.MaxPatternSize()));
+		});
+
+		return !PastCutoff(window.Address + window.Owned);
+	}
+
+	void MemoryScan::ScanChunk(const MemoryRegion& region, uintptr_t base, size_t size) {
+		// Every worker keeps its own window buffer between scans
+		thread_local RegionReader reader;
+
+		if (PastCutoff(base)) {
+			return;
+		}
+
+		auto read = [this](uintptr_t address, uint8_t* buffer, size_t length) {
+			const size_t bytesRead = m_Memory.Read(address, buffer, length);
+			if (bytesRead == 0) {
+				m_ReadFailed.store(true, std::memory_order_relaxed);
+			}
+			return bytesRead;
+		};
+
+		auto visit = [&](const RegionReader::Window& window) { return Visit(window, region); };
+		reader.ForEachWindow(base, size, m_Overlap, read, visit, region.Base + region.Size - (base + size));
+	}
+
+	// Small ranges are fetched with one batched read, each with the overlap that fits in its region. A batch isn't
+	// in address order when it spans two priority tiers, so the cutoff is checked range by range.
+	void MemoryScan::ScanBatch(const std::vector<ScanRange>& ranges) {
+		thread_local std::vector<uint8_t> buffer;
+		thread_local std::vector<ReadRequest> requests;
+		thread_local std::vector<const ScanRange*> requested;
+
+		auto readSize = [this](const ScanRange& range) {
+			return std::min(range.Size + m_Overlap, range.Region.Base + range.Region.Size - range.Begin);
+		};
+
+		size_t total = 0;
+		for (const auto& range: ranges) {
+			total += readSize(range);
+		}
+		if (buffer.size() < total) {
+			buffer.resize(total);
+		}
+
+		requests.clear();
+		requested.clear();
+		size_t offset = 0;
+		for (const auto& range: ranges) {
+			if (!PastCutoff(range.Begin)) {
+				requests.push_back({range.Begin, buffer.data() + offset, readSize(range)});
+				requested.push_back(&range);
+				offset += requests.back().Size;
+			}
+		}
+
+		if (requests.empty()) {
+			return;
+		}
+
+		m_Memory.ReadBatch(requests);
+
+		for (size_t i = 0; i < requests.size(); ++i) {
+			const ReadRequest& request = requests[i];
+			if (request.BytesRead < request.Size) {
+				m_ReadFailed.store(true, std::memory_order_relaxed);
+			}
+
+			if (request.BytesRead == 0 || PastCutoff(request.Address)) {
+				continue;
+			}
+
+			RegionReader::Window window;
+			window.Address = request.Address;
+			window.Data = std::span<const uint8_t>(request.Buffer, request.BytesRead);
+			window.Owned = std::min(requested[i]->Size, request.BytesRead);
+			Visit(window, requested[i]->Region);
+		}
+	}
+}// namespace Scanner
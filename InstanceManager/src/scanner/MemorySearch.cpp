@@ -0,0 +1,100 @@
+#include "scanner/MemorySearch.h"
+
+#include <mutex>
+
+#include "scanner/MemoryScan.h"
+#include "scanner/RegionCache.h"
+
+namespace Scanner {
+	namespace {
+		// Scans the process's cached layout first. A cached layout may be missing regions allocated since, or list
+		// freed ones, so unless settled() says the answer is known, the layout is read again and only the regions
+		// that are new get scanned.
+		void ScanLayout(const ProcessMemory& memory, MemoryScan& scan, const std::function<bool()>& settled) {
+			RegionCache& cache = RegionCache::GetInstance();
+			RegionCache::Plan plan = cache.Get(memory);
+
+			scan.Run(plan.Regions);
+
+			if (!plan.Fresh && (!settled() || scan.HadReadFailures())) {
+				scan.Run(cache.Refresh(memory));
+			} else if (scan.HadReadFailures()) {
+				cache.Invalidate(memory);
+			}
+		}
+	}// namespace
+
+	bool ScanMemory(const ProcessMemory& memory, const std::vector<Pattern>& patterns, const MemoryMatchCallback& onMatch) {
+		PatternSet set;
+		for (const auto& pattern: patterns) {
+			set.Add(pattern);
+		}
+
+		if (set.Count() == 0) {
+			return true;
+		}
+
+		std::mutex callbackMutex;
+		MemoryScan scan(memory, set, [&](const MemoryMatch& match) {
+			std::scoped_lock lock(callbackMutex);
+			if (!scan.Stopped() && !onMatch(match)) {
+				scan.Stop();
+			}
+		});
+
+		ScanLayout(memory, scan, [&]() { return scan.Stopped(); });
+		return !scan.Stopped();
+	}
+
+	std::string SearchMemory(const ProcessMemory& memory, const std::vector<SearchRule>& rules) {
+		PatternSet set;
+		for (const auto& rule: rules) {
+			set.Add(rule.Signature);
+		}
+
+		if (set.Count() == 0) {
+			return "";
+		}
+
+		std::mutex bestMutex;
+		std::string best;
+		size_t bestRule = rules.size();
+		uintptr_t bestAddress = UINTPTR_MAX;
+
+		// The lowest rule index wins, then the lowest address. Call with bestMutex held.
+		auto beatsBest = [&](size_t rule, uintptr_t address) {
+			return rule < bestRule || (rule == bestRule && address < bestAddress);
+		};
+
+		MemoryScan scan(memory, set, [&](const MemoryMatch& match) {
+			{
+				std::scoped_lock lock(bestMutex);
+				if (!beatsBest(match.PatternIndex, match.Address)) {
+					return;
+				}
+			}
+
+			const Pattern& signature = set.Get(match.PatternIndex);
+			std::string value = rules[match.PatternIndex].Extract(match.Data.data() + signature.Size(), match.Data.size() - signature.Size());
+			if (value.empty()) {
+				return;
+			}
+
+			std::scoped_lock lock(bestMutex);
+			if (beatsBest(match.PatternIndex, match.Address)) {
+				best = std::move(value);
+				bestRule = match.PatternIndex;
+				bestAddress = match.Address;
+
+				// Nothing above a first-rule value can win anymore, workers past it stop
+				if (match.PatternIndex == 0) {
+					scan.LowerCutoff(match.Address);
+				}
+			}
+		});
+
+		// Nothing a later run finds can replace a first-rule value, the cutoff already keeps it to lower addresses
+		ScanLayout(memory, scan, [&]() { return bestRule == 0; });
+		return best;
+	}
+}// namespace Scanner
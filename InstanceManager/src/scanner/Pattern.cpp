@@ -0,0 +1,257 @@
+#include "scanner/Pattern.h"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+#include "utils/cpu/CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SCANNER_HAS_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Scanner {
+	namespace {
+		using FindKernel = std::optional<size_t> (*)(const Pattern& pattern, const uint8_t* data, size_t size);
+
+		std::optional<size_t> FindScalar(const Pattern& pattern, const uint8_t* data, size_t size) {
+			const size_t anchor = pattern.AnchorOffset();
+			const uint8_t anchorByte = pattern.Value()[anchor];
+
+			// memchr is already vectorized by the C runtime, so the anchor filter is the fast part here too
+			const uint8_t* cursor = data + anchor;
+			const uint8_t* end = data + (size - pattern.Size()) + anchor + 1;
+			while (cursor < end) {
+				cursor = static_cast<const uint8_t*>(std::memchr(cursor, anchorByte, static_cast<size_t>(end - cursor)));
+				if (cursor == nullptr) {
+					break;
+				}
+
+				const size_t position = static_cast<size_t>(cursor - data) - anchor;
+				if (pattern.MatchesAt(data + position)) {
+					return position;
+				}
+				++cursor;
+			}
+
+			return std::nullopt;
+		}
+
+#if defined(SCANNER_HAS_X86)
+		bool ConfirmSse2(const Pattern& pattern, const uint8_t* candidate) {
+			const uint8_t* value = pattern.Value().data();
+			const uint8_t* mask = pattern.Mask().data();
+			const size_t size = pattern.Size();
+
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				__m128i bytes = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i)));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(value + i)))) != 0xFFFF) {
+					return false;
+				}
+			}
+
+			for (; i < size; ++i) {
+				if ((candidate[i] & mask[i]) != value[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		std::optional<size_t> FindSse2(const Pattern& pattern, const uint8_t* data, size_t size) {
+			const size_t last = size - pattern.Size();
+			const uint8_t* first = data + pattern.AnchorOffset();
+			const uint8_t* second = data + pattern.SecondAnchorOffset();
+			const __m128i firstByte = _mm_set1_epi8(static_cast<char>(pattern.Value()[pattern.AnchorOffset()]));
+			const __m128i secondByte = _mm_set1_epi8(static_cast<char>(pattern.Value()[pattern.SecondAnchorOffset()]));
+
+			size_t i = 0;
+			for (; i + 15 <= last; i += 16) {
+				__m128i hitsFirst = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i)), firstByte);
+				__m128i hitsSecond = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i)), secondByte);
+
+				for (uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(hitsFirst, hitsSecond))); bits != 0; bits &= bits - 1) {
+					const size_t position = i + std::countr_zero(bits);
+					if (ConfirmSse2(pattern, data + position)) {
+						return position;
+					}
+				}
+			}
+
+			for (; i <= last; ++i) {
+				if (pattern.MatchesAt(data + i)) {
+					return i;
+				}
+			}
+
+			return std::nullopt;
+		}
+
+		AVX2_TARGET bool ConfirmAvx2(const Pattern& pattern, const uint8_t* candidate) {
+			const uint8_t* value = pattern.Value().data();
+			const uint8_t* mask = pattern.Mask().data();
+			const size_t size = pattern.Size();
+
+			size_t i = 0;
+			for (; i + 32 <= size; i += 32) {
+				__m256i bytes = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(candidate + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i)));
+				if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(value + i))))) != 0xFFFFFFFFu) {
+					return false;
+				}
+			}
+
+			for (; i < size; ++i) {
+				if ((candidate[i] & mask[i]) != value[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		AVX2_TARGET std::optional<size_t> FindAvx2(const Pattern& pattern, const uint8_t* data, size_t size) {
+			const size_t last = size - pattern.Size();
+			const uint8_t* first = data + pattern.AnchorOffset();
+			const uint8_t* second = data + pattern.SecondAnchorOffset();
+			const __m256i firstByte = _mm256_set1_epi8(static_cast<char>(pattern.Value()[pattern.AnchorOffset()]));
+			const __m256i secondByte = _mm256_set1_epi8(static_cast<char>(pattern.Value()[pattern.SecondAnchorOffset()]));
+
+			size_t i = 0;
+			for (; i + 31 <= last; i += 32) {
+				__m256i hitsFirst = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)), firstByte);
+				__m256i hitsSecond = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i)), secondByte);
+
+				for (uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(hitsFirst, hitsSecond))); bits != 0; bits &= bits - 1) {
+					const size_t position = i + std::countr_zero(bits);
+					if (ConfirmAvx2(pattern, data + position)) {
+						return position;
+					}
+				}
+			}
+
+			for (; i <= last; ++i) {
+				if (pattern.MatchesAt(data + i)) {
+					return i;
+				}
+			}
+
+			return std::nullopt;
+		}
+#endif
+
+		FindKernel SelectKernel() {
+#if defined(SCANNER_HAS_X86)
+			const CpuFeatures& cpu = CpuFeatures::Get();
+			if (cpu.Avx2) {
+				return FindAvx2;
+			}
+			if (cpu.Sse2) {
+				return FindSse2;
+			}
+#endif
+			return FindScalar;
+		}
+	}// namespace
+
+	Pattern::Pattern(std::vector<uint8_t> value, std::vector<uint8_t> mask) : m_Value(std::move(value)), m_Mask(std::move(mask)) {
+		m_Mask.resize(m_Value.size(), 0xFF);
+
+		// Kept pre-masked, a candidate matches when (data & mask) == value
+		for (size_t i = 0; i < m_Value.size(); ++i) {
+			m_Value[i] &= m_Mask[i];
+		}
+
+		PatternAnchors anchors = ChooseAnchors(m_Value, m_Mask);
+		m_Anchor = anchors.First;
+		m_SecondAnchor = anchors.Second;
+	}
+
+	std::optional<Pattern> Pattern::Parse(std::string_view signature) {
+		std::vector<uint8_t> value;
+		std::vector<uint8_t> mask;
+
+		while (!signature.empty()) {
+			size_t end = signature.find(' ');
+			std::string_view token = signature.substr(0, end);
+			signature = end == std::string_view::npos ? std::string_view() : signature.substr(end + 1);
+
+			if (token.empty()) {
+				continue;
+			}
+
+			if (token == "?" || token == "??") {
+				value.push_back(0);
+				mask.push_back(0x00);
+				continue;
+			}
+
+			uint8_t byte = 0;
+			auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), byte, 16);
+			if (ec != std::errc() || ptr != token.data() + token.size()) {
+				return std::nullopt;
+			}
+
+			value.push_back(byte);
+			mask.push_back(0xFF);
+		}
+
+		return Pattern(std::move(value), std::move(mask));
+	}
+
+	Pattern Pattern::FromBytes(std::span<const uint8_t> bytes) {
+		return Pattern(std::vector<uint8_t>(bytes.begin(), bytes.end()), std::vector<uint8_t>(bytes.size(), 0xFF));
+	}
+
+	bool Pattern::MatchesAt(const uint8_t* data) const {
+		for (size_t i = 0; i < m_Value.size(); ++i) {
+			if ((data[i] & m_Mask[i]) != m_Value[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::optional<size_t> Pattern::Find(std::span<const uint8_t> data) const {
+		return Find(data, Kernel::Auto);
+	}
+
+	std::optional<size_t> Pattern::Find(std::span<const uint8_t> data, Kernel kernel) const {
+		if (m_Value.empty() || data.size() < m_Value.size()) {
+			return std::nullopt;
+		}
+
+		// Nothing to filter on when every byte is a wildcard
+		if (m_Mask[m_Anchor] == 0x00) {
+			return 0;
+		}
+
+		static const FindKernel best = SelectKernel();
+		FindKernel selected = best;
+
+		switch (kernel) {
+			case Kernel::Scalar:
+				selected = FindScalar;
+				break;
+#if defined(SCANNER_HAS_X86)
+			case Kernel::Sse2:
+				selected = CpuFeatures::Get().Sse2 ? FindSse2 : best;
+				break;
+			case Kernel::Avx2:
+				selected = CpuFeatures::Get().Avx2 ? FindAvx2 : best;
+				break;
+#endif
+			default:
+				break;
+		}
+
+		return selected(*this, data.data(), data.size());
+	}
+}// namespace Scanner
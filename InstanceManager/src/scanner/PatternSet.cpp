@@ -0,0 +1,168 @@
+#include "scanner/PatternSet.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCANNER_HAS_SSE2
+#endif
+
+namespace Scanner {
+	namespace {
+		constexpr size_t MAX_START_BYTES = 4;
+	}// namespace
+
+	size_t PatternSet::Add(Pattern pattern) {
+		const size_t index = m_Patterns.size();
+		const size_t prefixSize = std::min(pattern.Size(), WORD_BITS);
+
+		auto word = std::ranges::find_if(m_Words, [prefixSize](const StateWord& w) { return w.BitsUsed + prefixSize <= WORD_BITS; });
+		if (word == m_Words.end()) {
+			word = m_Words.emplace(m_Words.end());
+		}
+
+		const size_t firstBit = word->BitsUsed;
+		for (size_t i = 0; i < prefixSize; ++i) {
+			const uint64_t bit = uint64_t{1} << (firstBit + i);
+			const uint8_t value = pattern.Value()[i];
+			const uint8_t mask = pattern.Mask()[i];
+
+			// Every byte that equals the value under the mask moves the automaton forward at this position
+			for (size_t byte = 0; byte < 256; ++byte) {
+				if ((static_cast<uint8_t>(byte) & mask) == value) {
+					word->Accept[byte] |= bit;
+				}
+			}
+		}
+
+		if (prefixSize > 0) {
+			word->Start |= uint64_t{1} << firstBit;
+			word->Final |= uint64_t{1} << (firstBit + prefixSize - 1);
+			word->Finals.emplace_back(firstBit + prefixSize - 1, index);
+		}
+		word->BitsUsed += prefixSize;
+
+		// While no pattern is in progress the scan jumps straight to the next byte that can start one
+		m_StartBytes.clear();
+		for (size_t byte = 0; byte < 256; ++byte) {
+			if (std::ranges::any_of(m_Words, [byte](const StateWord& w) { return (w.Accept[byte] & w.Start) != 0; })) {
+				m_StartBytes.push_back(static_cast<uint8_t>(byte));
+			}
+		}
+		if (m_StartBytes.size() > MAX_START_BYTES) {
+			m_StartBytes.clear();
+		}
+
+		m_MaxPatternSize = std::max(m_MaxPatternSize, pattern.Size());
+		m_PrefixSizes.push_back(prefixSize);
+		m_Patterns.push_back(std::move(pattern));
+		return index;
+	}
+
+	bool PatternSet::Report(std::span<const uint8_t> data, size_t end, const StateWord& word, uint64_t hits, const MatchCallback& onMatch) const {
+		for (const auto& [bit, index]: word.Finals) {
+			if (!(hits >> bit & 1)) {
+				continue;
+			}
+
+			const size_t start = end + 1 - m_PrefixSizes[index];
+			const Pattern& pattern = m_Patterns[index];
+
+			// Only the first 64 bytes went through the automaton, the rest is checked here
+			if (pattern.Size() > m_PrefixSizes[index] && (start + pattern.Size() > data.size() || !pattern.MatchesAt(data.data() + start))) {
+				continue;
+			}
+
+			if (!onMatch(PatternMatch{index, start})) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	size_t PatternSet::NextStart(std::span<const uint8_t> data, size_t from) const {
+		if (m_StartBytes.empty()) {
+			return from;
+		}
+
+		size_t i = from;
+#if defined(SCANNER_HAS_SSE2)
+		__m128i needles[MAX_START_BYTES];
+		for (size_t n = 0; n < MAX_START_BYTES; ++n) {
+			needles[n] = _mm_set1_epi8(static_cast<char>(m_StartBytes[std::min(n, m_StartBytes.size() - 1)]));
+		}
+
+		for (; i + 16 <= data.size(); i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + i));
+			__m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, needles[0]), _mm_cmpeq_epi8(chunk, needles[1])),
+			                            _mm_or_si128(_mm_cmpeq_epi8(chunk, needles[2]), _mm_cmpeq_epi8(chunk, needles[3])));
+			if (uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(hits)); bits != 0) {
+				return i + std::countr_zero(bits);
+			}
+		}
+#endif
+
+		for (; i < data.size(); ++i) {
+			if (std::ranges::find(m_StartBytes, data[i]) != m_StartBytes.end()) {
+				return i;
+			}
+		}
+
+		return data.size();
+	}
+
+	// One pattern gains nothing from the automaton, the anchored SIMD search is much faster
+	bool PatternSet::ScanSingle(std::span<const uint8_t> data, const MatchCallback& onMatch) const {
+		const Pattern& pattern = m_Patterns.front();
+
+		size_t start = 0;
+		while (auto offset = pattern.Find(data.subspan(start))) {
+			if (!onMatch(PatternMatch{0, start + *offset})) {
+				return false;
+			}
+			start += *offset + 1;
+		}
+
+		return true;
+	}
+
+	bool PatternSet::Scan(std::span<const uint8_t> data, const MatchCallback& onMatch) const {
+		if (m_Patterns.size() == 1) {
+			return ScanSingle(data, onMatch);
+		}
+
+		if (m_Words.size() == 1) {
+			const StateWord& word = m_Words.front();
+			uint64_t state = 0;
+
+			for (size_t i = 0; i < data.size(); ++i) {
+				if (state == 0 && (i = NextStart(data, i)) == data.size()) {
+					break;
+				}
+
+				state = ((state << 1) | word.Start) & word.Accept[data[i]];
+				if ((state & word.Final) != 0 && !Report(data, i, word, state & word.Final, onMatch)) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Pattern bits never cross from one word into the next, so every word shifts on its own
+		std::vector<uint64_t> states(m_Words.size(), 0);
+		for (size_t i = 0; i < data.size(); ++i) {
+			for (size_t w = 0; w < m_Words.size(); ++w) {
+				const StateWord& word = m_Words[w];
+				states[w] = ((states[w] << 1) | word.Start) & word.Accept[data[i]];
+				if ((states[w] & word.Final) != 0 && !Report(data, i, word, states[w] & word.Final, onMatch)) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+}// namespace Scanner
@@ -0,0 +1,323 @@
+#include "scanner/ProcessMemory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#endif
+
+namespace Scanner {
+	void ProcessMemory::ReadBatch(std::span<ReadRequest> requests) const {
+		for (auto& request: requests) {
+			request.BytesRead = Read(request.Address, request.Buffer, request.Size);
+		}
+	}
+
+	bool ProcessMemory::ResetWriteTracking() const {
+		return false;
+	}
+
+	bool ProcessMemory::WrittenPages(uintptr_t, size_t, std::vector<bool>&) const {
+		return false;
+	}
+
+#ifdef _WIN32
+	namespace {
+		class WindowsProcessMemory final : public ProcessMemory {
+		public:
+			WindowsProcessMemory(HANDLE process, bool owned) : m_Process(process), m_Owned(owned) {}
+
+			~WindowsProcessMemory() override {
+				if (m_Owned) {
+					CloseHandle(m_Process);
+				}
+			}
+
+			uint32_t Pid() const override {
+				return GetProcessId(m_Process);
+			}
+
+			uint64_t StartTime() const override {
+				FILETIME creation, exit, kernel, user;
+				if (!GetProcessTimes(m_Process, &creation, &exit, &kernel, &user)) {
+					return 0;
+				}
+				return (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+			}
+
+			std::vector<MemoryRegion> Regions() const override {
+				std::vector<MemoryRegion> regions;
+
+				uintptr_t address = 0;
+				MEMORY_BASIC_INFORMATION mbi = {};
+				while (VirtualQueryEx(m_Process, reinterpret_cast<LPCVOID>(address), &mbi, sizeof(mbi))) {
+					if (mbi.State == MEM_COMMIT) {
+						constexpr DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+						constexpr DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+						MemoryRegion region;
+						region.Base = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
+						region.Size = mbi.RegionSize;
+						region.Readable = !(mbi.Protect & PAGE_NOACCESS) && !(mbi.Protect & PAGE_GUARD);
+						region.Writable = (mbi.Protect & writable) != 0;
+						region.Executable = (mbi.Protect & executable) != 0;
+						region.IsImage = mbi.Type == MEM_IMAGE;
+						region.IsPrivate = mbi.Type == MEM_PRIVATE;
+						regions.push_back(region);
+					}
+
+					// Move to the next memory region
+					address = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+				}
+
+				return regions;
+			}
+
+			size_t Read(uintptr_t address, uint8_t* buffer, size_t size) const override {
+				SIZE_T bytesRead = 0;
+				ReadProcessMemory(m_Process, reinterpret_cast<LPCVOID>(address), buffer, size, &bytesRead);
+				return static_cast<size_t>(bytesRead);
+			}
+
+		private:
+			HANDLE m_Process;
+			bool m_Owned;
+		};
+	}// namespace
+
+	std::unique_ptr<ProcessMemory> ProcessMemory::Open(uint32_t pid) {
+		HANDLE process = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION, FALSE, pid);
+		if (process == NULL) {
+			return nullptr;
+		}
+		return std::make_unique<WindowsProcessMemory>(process, true);
+	}
+
+	std::unique_ptr<ProcessMemory> ProcessMemory::FromHandle(void* processHandle) {
+		return std::make_unique<WindowsProcessMemory>(static_cast<HANDLE>(processHandle), false);
+	}
+#else
+	namespace {
+		// /proc/<pid>/maps for the layout, process_vm_readv for the reads, no ptrace stop needed
+		class LinuxProcessMemory final : public ProcessMemory {
+		public:
+			explicit LinuxProcessMemory(pid_t pid) : m_Pid(pid) {}
+
+			uint32_t Pid() const override {
+				return static_cast<uint32_t>(m_Pid);
+			}
+
+			// Field 22 of /proc/<pid>/stat, in clock ticks since boot. The command name before it may contain spaces,
+			// so fields are counted from its closing parenthesis.
+			uint64_t StartTime() const override {
+				std::ifstream stat("/proc/" + std::to_string(m_Pid) + "/stat");
+				std::string line;
+				std::getline(stat, line);
+
+				const size_t nameEnd = line.rfind(')');
+				if (nameEnd == std::string::npos) {
+					return 0;
+				}
+
+				std::istringstream fields(line.substr(nameEnd + 1));
+				std::string skipped;
+				for (int field = 3; field < 22; ++field) {
+					fields >> skipped;
+				}
+
+				uint64_t startTime = 0;
+				fields >> startTime;
+				return startTime;
+			}
+
+			std::vector<MemoryRegion> Regions() const override {
+				std::vector<MemoryRegion> regions;
+
+				std::ifstream maps("/proc/" + std::to_string(m_Pid) + "/maps");
+				std::string line;
+				while (std::getline(maps, line)) {
+					// start-end perms offset dev inode [path]
+					std::istringstream fields(line);
+					std::string range, perms, offset, device, path;
+					unsigned long inode = 0;
+					fields >> range >> perms >> offset >> device >> inode;
+					std::getline(fields >> std::ws, path);
+
+					const size_t dash = range.find('-');
+					if (dash == std::string::npos || perms.size() < 4) {
+						continue;
+					}
+
+					const uintptr_t start = std::stoull(range.substr(0, dash), nullptr, 16);
+					const uintptr_t end = std::stoull(range.substr(dash + 1), nullptr, 16);
+
+					MemoryRegion region;
+					region.Base = start;
+					region.Size = end - start;
+					// The kernel's vvar pages can't be read from another process even though they show up readable
+					region.Readable = perms[0] == 'r' && path != "[vvar]";
+					region.Writable = perms[1] == 'w';
+					region.Executable = perms[2] == 'x';
+					region.IsImage = inode != 0;
+					region.IsPrivate = perms[3] == 'p' && inode == 0;
+					regions.push_back(region);
+				}
+
+				return regions;
+			}
+
+			size_t Read(uintptr_t address, uint8_t* buffer, size_t size) const override {
+				iovec local{buffer, size};
+				iovec remote{reinterpret_cast<void*>(address), size};
+
+				ssize_t bytesRead = process_vm_readv(m_Pid, &local, 1, &remote, 1, 0);
+				return bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+			}
+
+			// Up to IOV_MAX ranges per system call. A failing range ends the call early, so the ranges after it
+			// start a new batch.
+			void ReadBatch(std::span<ReadRequest> requests) const override {
+				std::vector<iovec> local;
+				std::vector<iovec> remote;
+
+				size_t next = 0;
+				while (next < requests.size()) {
+					const size_t count = std::min<size_t>(requests.size() - next, IOV_MAX);
+
+					local.clear();
+					remote.clear();
+					for (size_t i = next; i < next + count; ++i) {
+						local.push_back({requests[i].Buffer, requests[i].Size});
+						remote.push_back({reinterpret_cast<void*>(requests[i].Address), requests[i].Size});
+						requests[i].BytesRead = 0;
+					}
+
+					ssize_t result = process_vm_readv(m_Pid, local.data(), count, remote.data(), count, 0);
+					size_t remaining = result > 0 ? static_cast<size_t>(result) : 0;
+
+					// The kernel fills the ranges in order and stops at the first one it can't finish
+					size_t i = next;
+					for (; i < next + count && remaining >= requests[i].Size; ++i) {
+						requests[i].BytesRead = requests[i].Size;
+						remaining -= requests[i].Size;
+					}
+
+					if (i < next + count) {
+						requests[i].BytesRead = remaining;
+						++i;
+					}
+
+					next = i;
+				}
+			}
+
+			// Soft-dirty bits: writing 4 to clear_refs clears them, the kernel sets bit 55 of a page's pagemap entry
+			// again on the next write to it. Clearing is process wide, anything else using the bits on the target
+			// shares the interval with us.
+			bool ResetWriteTracking() const override {
+				if (!m_SoftDirty.has_value()) {
+					m_SoftDirty = DetectSoftDirty();
+				}
+
+				if (!*m_SoftDirty) {
+					return false;
+				}
+
+				std::ofstream clearRefs("/proc/" + std::to_string(m_Pid) + "/clear_refs");
+				clearRefs << "4";
+				clearRefs.flush();
+				return static_cast<bool>(clearRefs);
+			}
+
+			bool WrittenPages(uintptr_t base, size_t size, std::vector<bool>& written) const override {
+				if (!m_SoftDirty.value_or(false)) {
+					return false;
+				}
+
+				std::vector<uint64_t> entries(size / PAGE_BYTES);
+				if (!ReadPagemap(base, entries)) {
+					return false;
+				}
+
+				written.assign(entries.size(), false);
+				for (size_t i = 0; i < entries.size(); ++i) {
+					written[i] = (entries[i] & SOFT_DIRTY_BIT) != 0;
+				}
+				return true;
+			}
+
+		private:
+			static constexpr uint64_t SOFT_DIRTY_BIT = 1ull << 55;
+			static constexpr uint64_t PRESENT_BIT = 1ull << 63;
+			static constexpr size_t DETECT_PAGES = 1024;
+
+			bool ReadPagemap(uintptr_t base, std::vector<uint64_t>& entries) const {
+				int pagemap = open(("/proc/" + std::to_string(m_Pid) + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC);
+				if (pagemap < 0) {
+					return false;
+				}
+
+				const size_t bytes = entries.size() * sizeof(uint64_t);
+				size_t done = 0;
+				while (done < bytes) {
+					ssize_t result = pread(pagemap, reinterpret_cast<char*>(entries.data()) + done, bytes - done, static_cast<off_t>((base / PAGE_BYTES) * sizeof(uint64_t) + done));
+					if (result <= 0) {
+						break;
+					}
+					done += static_cast<size_t>(result);
+				}
+
+				close(pagemap);
+				return done == bytes;
+			}
+
+			// Kernels built without soft-dirty support accept the clear but never set the bit. Until the first clear,
+			// every page the process touched is soft-dirty where it is supported, so a sample of heap pages tells.
+			bool DetectSoftDirty() const {
+				size_t sampled = 0;
+				for (const auto& region: Regions()) {
+					if (!region.IsPrivate || !region.Writable || !region.Readable) {
+						continue;
+					}
+
+					std::vector<uint64_t> entries(std::min(region.Size / PAGE_BYTES, DETECT_PAGES - sampled));
+					if (!ReadPagemap(region.Base, entries)) {
+						return false;
+					}
+
+					for (uint64_t entry: entries) {
+						if ((entry & PRESENT_BIT) && (entry & SOFT_DIRTY_BIT)) {
+							return true;
+						}
+					}
+
+					sampled += entries.size();
+					if (sampled >= DETECT_PAGES) {
+						break;
+					}
+				}
+				return false;
+			}
+
+			pid_t m_Pid;
+			mutable std::optional<bool> m_SoftDirty;
+		};
+	}// namespace
+
+	std::unique_ptr<ProcessMemory> ProcessMemory::Open(uint32_t pid) {
+		if (access(("/proc/" + std::to_string(pid) + "/maps").c_str(), R_OK) != 0) {
+			return nullptr;
+		}
+		return std::make_unique<LinuxProcessMemory>(static_cast<pid_t>(pid));
+	}
+#endif
+}// namespace Scanner
@@ -0,0 +1,88 @@
+#include "scanner/RegionCache.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+namespace Scanner {
+	namespace {
+		// Lower scans first
+		int Tier(const MemoryRegion& region) {
+			if (region.IsPrivate && region.Writable && !region.Executable) {
+				return 0;
+			}
+			if (region.Writable) {
+				return 1;
+			}
+			return 2;
+		}
+	}// namespace
+
+	std::vector<MemoryRegion> RegionCache::Prioritize(std::vector<MemoryRegion> regions) {
+		std::erase_if(regions, [](const MemoryRegion& region) {
+			return !region.Readable || region.IsImage || region.Size == 0;
+		});
+
+		// Address order within a tier, the search's cutoff prunes best when low addresses come first
+		std::ranges::stable_sort(regions, {}, Tier);
+		return regions;
+	}
+
+	void RegionCache::DropExpired(std::chrono::steady_clock::time_point now) {
+		std::erase_if(m_Entries, [now](const auto& entry) {
+			return now - entry.second.TakenAt > MAX_AGE;
+		});
+	}
+
+	RegionCache::Plan RegionCache::Get(const ProcessMemory& memory) {
+		const uint32_t pid = memory.Pid();
+		const uint64_t startTime = memory.StartTime();
+		const auto now = std::chrono::steady_clock::now();
+
+		{
+			std::scoped_lock lock(m_Mutex);
+			DropExpired(now);
+
+			auto it = m_Entries.find(pid);
+			if (it != m_Entries.end() && it->second.StartTime == startTime) {
+				return Plan{it->second.Regions, false};
+			}
+		}
+
+		Plan plan{Prioritize(memory.Regions()), true};
+
+		std::scoped_lock lock(m_Mutex);
+		m_Entries[pid] = Entry{startTime, now, plan.Regions};
+		return plan;
+	}
+
+	std::vector<MemoryRegion> RegionCache::Refresh(const ProcessMemory& memory) {
+		const uint32_t pid = memory.Pid();
+		std::vector<MemoryRegion> regions = Prioritize(memory.Regions());
+
+		std::vector<MemoryRegion> previous;
+		{
+			std::scoped_lock lock(m_Mutex);
+			auto& entry = m_Entries[pid];
+			previous = std::exchange(entry.Regions, regions);
+			entry.StartTime = memory.StartTime();
+			entry.TakenAt = std::chrono::steady_clock::now();
+		}
+
+		// A region that moved or grew counts as new, it is scanned whole
+		std::set<std::pair<uintptr_t, size_t>> known;
+		for (const auto& region: previous) {
+			known.emplace(region.Base, region.Size);
+		}
+
+		std::erase_if(regions, [&](const MemoryRegion& region) {
+			return known.contains({region.Base, region.Size});
+		});
+		return regions;
+	}
+
+	void RegionCache::Invalidate(const ProcessMemory& memory) {
+		std::scoped_lock lock(m_Mutex);
+		m_Entries.erase(memory.Pid());
+	}
+}// namespace Scanner
@@ -0,0 +1,33 @@
+#include "scanner/RegionReader.h"
+
+#include <algorithm>
+
+namespace Scanner {
+	bool RegionReader::ForEachWindow(uintptr_t base, size_t size, size_t overlap, const ReadFunction& read, const WindowVisitor& visit, size_t readableTail) {
+		// Only ever grows, so a reader that is kept around stops allocating after its first scan
+		if (m_Buffer.size() < m_WindowSize + overlap) {
+			m_Buffer.resize(m_WindowSize + overlap);
+		}
+
+		for (size_t offset = 0; offset < size; offset += m_WindowSize) {
+			const size_t owned = std::min(m_WindowSize, size - offset);
+			const size_t length = std::min(m_WindowSize + overlap, size + readableTail - offset);
+
+			const size_t bytesRead = read(base + offset, m_Buffer.data(), length);
+			if (bytesRead == 0) {
+				continue;
+			}
+
+			Window window;
+			window.Address = base + offset;
+			window.Data = std::span<const uint8_t>(m_Buffer.data(), bytesRead);
+			window.Owned = std::min(owned, bytesRead);
+
+			if (!visit(window)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+}// namespace Scanner
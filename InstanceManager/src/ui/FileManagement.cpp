@@ -11,15 +11,19 @@ void FileManagement::Draw(const char* title, bool* p_open) {
 	}
 
 	if (ImGui::Button("Refresh")) {
-		cache.clear();
+		for (auto& [name, index]: indexes) {
+			index->Invalidate();
+		}
 	}
 
 	auto SelectedIndices = std::views::iota(0, static_cast<int>(instances.size())) | std::views::filter([&](int i) { return selection[i]; });
 
 	for (int i: SelectedIndices) {
-		if (ImGui::TreeNode(g_InstanceControl.GetInstance(instances[i]).Name.c_str())) {
-			std::string path = FS::FindFiles(fmt::format(R"({}\AppData\Local\Packages)", Native::GetUserProfilePath()), g_InstanceControl.GetInstance(instances[i]).Name + "_")[0];
-			DisplayFilesAndDirectories(g_InstanceControl.GetInstance(instances[i]).PackageFamilyName, path, true);
+		const Roblox::Instance& instance = g_InstanceControl.GetInstance(instances[i]);
+		if (ImGui::TreeNode(instance.Name.c_str())) {
+			if (DirectoryIndex* index = GetIndex(instance)) {
+				DisplayFilesAndDirectories(*index, instance.PackageFamilyName, index->GetRoot());
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -27,36 +31,39 @@ void FileManagement::Draw(const char* title, bool* p_open) {
 	ImGui::End();
 }
 
+// The package folder is looked up once, after that the index keeps itself current
+DirectoryIndex* FileManagement::GetIndex(const Roblox::Instance& instance) {
+	auto it = indexes.find(instance.PackageFamilyName);
+	if (it != indexes.end()) {
+		return it->second.get();
+	}
 
-void FileManagement::DisplayFilesAndDirectories(const std::string& packageFamilyName, const std::filesystem::path& directory, bool forceRefresh) {
-
-	if (forceRefresh || cache.find(directory.string()) == cache.end()) {
-		cache[directory.string()] = std::vector<DirectoryEntryInfo>();
+	std::vector<std::string> paths = FS::FindFiles(fmt::format(R"({}\AppData\Local\Packages)", Native::GetUserProfilePath()), instance.Name + "_");
+	if (paths.empty()) {
+		return nullptr;
+	}
 
-		for (const auto& entry: fs::directory_iterator(directory)) {
-			DirectoryEntryInfo info;
-			info.entry = entry;
-			info.filename = entry.path().filename().string();
-			info.uniqueId = directory.string() + "/" + info.filename;
+	auto [inserted, _] = indexes.emplace(instance.PackageFamilyName, std::make_unique<DirectoryIndex>(paths[0]));
+	return inserted->second.get();
+}
 
-			cache[directory.string()].push_back(info);
-		}
-	}
+void FileManagement::DisplayFilesAndDirectories(DirectoryIndex& index, const std::string& packageFamilyName, const std::filesystem::path& directory) {
+	DirectoryIndex::Listing listing = index.List(directory);
 
-	for (const auto& info: cache[directory.string()]) {
-		if (fs::is_directory(info.entry.status())) {
+	for (const auto& info: *listing) {
+		if (info.isDirectory) {
 			bool isOpen = ImGui::TreeNode(info.filename.c_str());
 
 			ImGui::PushID(info.uniqueId.c_str());
 			if (ImGui::BeginPopupContextItem()) {
 				if (ImGui::MenuItem("Open in explorer")) {
-					if (!Native::OpenInExplorer(info.entry.path().string())) {
-						CoreLogger::Log(LogLevel::ERR, "Failed to open directory {}", info.entry.path().string());
+					if (!Native::OpenInExplorer(info.path.string())) {
+						CoreLogger::Log(LogLevel::ERR, "Failed to open directory {}", info.path.string());
 					}
 				}
 
 				if (ImGui::MenuItem("Clone")) {
-					CloneDir(packageFamilyName, info.entry.path().string());
+					CloneDir(packageFamilyName, info.path.string());
 				}
 
 				ImGui::EndPopup();
@@ -64,17 +71,17 @@ void FileManagement::DisplayFilesAndDirectories(const std::string& packageFamily
 			ImGui::PopID();
 
 			if (isOpen) {
-				DisplayFilesAndDirectories(packageFamilyName, info.entry.path());
+				DisplayFilesAndDirectories(index, packageFamilyName, info.path);
 				ImGui::TreePop();
 			}
-		} else if (fs::is_regular_file(info.entry.status())) {
+		} else if (info.isRegularFile) {
 			ImGui::Selectable(info.filename.c_str());
 
 			// Context menu for file
 			ImGui::PushID(info.uniqueId.c_str());
 			if (ImGui::BeginPopupContextItem()) {
 				if (ImGui::MenuItem("Open in explorer")) {
-					Native::OpenInExplorer(info.entry.path().string(), true);
+					Native::OpenInExplorer(info.path.string(), true);
 				}
 				// ... add more file menu items
 				ImGui::EndPopup();
@@ -1,7 +1,9 @@
 #include "ui/InstanceManager.h"
 
+#include <mutex>
 #include <opencv2/opencv.hpp>
 
+#include "appx/IntegrityScanner.h"
 #include "config/Config.hpp"
 #include "imgui_stdlib.h"
 #include "instance-control/InstanceControl.h"
@@ -12,15 +14,35 @@
 #include "ui/CustomWidgets.hpp"
 #include "ui/UI.h"
 #include "utils/Utils.hpp"
+#include "utils/filesystem/DeletionService.h"
 #include "utils/string/StringUtils.h"
 
 std::vector<std::string> g_InstanceNames = g_InstanceControl.GetInstanceNames();
 std::vector<bool> g_Selection;
 
+// Adds instances created since the list was read, each one unselected, at its place in the sorted list
+static void AddNewInstances() {
+	for (const auto& str: Roblox::GetNewInstances(g_InstanceNames)) {
+		auto pos = std::lower_bound(g_InstanceNames.begin(), g_InstanceNames.end(), str,
+		                            [](const std::string& a, const std::string& b) {
+			                            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+			                                                                [](char ca, char cb) {
+				                                                                return std::tolower(ca) < std::tolower(cb);
+			                                                                });
+		                            });
+
+		const auto index = std::distance(g_InstanceNames.begin(), pos);
+		g_InstanceNames.insert(pos, str);
+		if (index <= std::ssize(g_Selection)) {
+			g_Selection.insert(g_Selection.begin() + index, false);
+		}
+	}
+}
+
 InstanceManager::InstanceManager() : m_FileManagement(g_InstanceNames, g_Selection),
                                      m_AutoRelaunch(g_InstanceNames),
-                                     m_QueuedThreadPool(1),
-                                     m_ThreadPool(4) {}
+                                     m_ThreadPool(4),
+                                     m_Lanes(m_ThreadPool) {}
 
 void InstanceManager::StartUp() {
 	std::ranges::sort(g_InstanceNames, [](const std::string& a, const std::string& b) {
@@ -31,6 +53,7 @@ void InstanceManager::StartUp() {
 	});
 
 	std::filesystem::create_directory("Instances");
+	DeletionService::GetInstance().EmptyTrash("Instances");
 
 	if (!std::filesystem::exists("config.json")) {
 		std::ofstream ofs("config.json", std::ofstream::out | std::ofstream::trunc);
@@ -41,6 +64,7 @@ void InstanceManager::StartUp() {
 		        {"lastDelay", ""},
 		        {"lastInterval", ""},
 		        {"lastInjectDelay", ""},
+		        {"cloneMode", "hardlink"},
 		};
 
 		ofs << j.dump(4);
@@ -60,7 +84,26 @@ void InstanceManager::StartUp() {
 	fileLogger.Initialize(logPath);
 }
 
+void InstanceManager::QueueListEdit(std::function<void()> edit) {
+	std::scoped_lock lock(m_ListEditsMutex);
+	m_ListEdits.push_back(std::move(edit));
+}
+
+void InstanceManager::ApplyListEdits() {
+	std::vector<std::function<void()>> edits;
+	{
+		std::scoped_lock lock(m_ListEditsMutex);
+		edits.swap(m_ListEdits);
+	}
+
+	for (auto& edit: edits) {
+		edit();
+	}
+}
+
 void InstanceManager::Update() {
+	ApplyListEdits();
+
 	ImGui::Begin("Instance Manager", nullptr);
 
 	if (g_Selection.size() != g_InstanceNames.size()) {
@@ -150,6 +193,10 @@ void InstanceManager::RenderContextMenu(int n) {
 		ImGui::SameLine();
 
 		RenderRemoveInstances();
+
+		ImGui::SameLine();
+
+		RenderVerifyInstances();
 	}
 }
 
@@ -278,18 +325,18 @@ void InstanceManager::RenderLaunchButton(const std::string& placeid, const std::
 
 	if (ui::GreenButton("Launch")) {
 		Utils::ForEachSelectedInstance(g_Selection, [this, placeid, linkcode, launchdelay](int idx) {
-			auto callback = [idx]() {
-				CoreLogger::Log(LogLevel::INFO, "Launched {}", g_InstanceNames[idx]);
+			const std::string name = g_InstanceNames[idx];
+			auto callback = [name]() {
+				CoreLogger::Log(LogLevel::INFO, "Launched {}", name);
 			};
 
-			CoreLogger::Log(LogLevel::INFO, "Launching {}...", g_InstanceNames[idx]);
-
-			this->m_QueuedThreadPool.SubmitTask([launchdelay]() {
-				std::this_thread::sleep_for(std::chrono::milliseconds((int) (launchdelay * 1000)));
-			});
+			CoreLogger::Log(LogLevel::INFO, "Launching {}...", name);
 
-			this->m_QueuedThreadPool.SubmitTask(callback, [idx, placeid, linkcode]() {
-				g_InstanceControl.LaunchInstance(g_InstanceNames[idx], placeid, linkcode);
+			// Launches share a lane, so each one's delay starts when the one before it is done and staggers them
+			// without holding a worker. The instance's own lane keeps a launch in order with deleting or updating it.
+			const auto delay = std::chrono::milliseconds((int) (launchdelay * 1000));
+			this->m_Lanes.SubmitAfter({"launch", name}, delay, callback, [name, placeid, linkcode]() {
+				g_InstanceControl.LaunchInstance(name, placeid, linkcode);
 			});
 		});
 	}
@@ -352,12 +399,24 @@ void InstanceManager::RenderTerminate() {
 void InstanceManager::SubmitDeleteTask(int idx) {
 	const std::string instanceName = g_InstanceNames[idx];
 
-	auto callback = [instanceName, idx]() {
-		g_InstanceNames.erase(g_InstanceNames.begin() + idx);
+	// Deletes of other instances may have finished first and moved it, so it is looked up by name
+	auto callback = [this, instanceName]() {
+		QueueListEdit([instanceName]() {
+			auto it = std::ranges::find(g_InstanceNames, instanceName);
+			if (it == g_InstanceNames.end()) {
+				return;
+			}
+
+			const auto index = std::distance(g_InstanceNames.begin(), it);
+			g_InstanceNames.erase(it);
+			if (index < std::ssize(g_Selection)) {
+				g_Selection.erase(g_Selection.begin() + index);
+			}
+		});
 		CoreLogger::Log(LogLevel::INFO, "{} has been deleted", instanceName);
 	};
 
-	this->m_QueuedThreadPool.SubmitTask(callback, [instanceName]() {
+	this->m_Lanes.SubmitTask({instanceName}, callback, [instanceName]() {
 		try {
 			g_InstanceControl.DeleteInstance(instanceName);
 		} catch (const std::exception& e) {
@@ -430,36 +489,31 @@ void InstanceManager::RenderCreateInstance() {
 	ImGui::InputTextWithHint("##NameStr", "Input the instance name here...", &instanceNameBuf, ImGuiInputTextFlags_CallbackCharFilter, ui::FilterCallback);
 
 	if (ImGui::IsItemHovered())
-		ImGui::SetTooltip(R"(Disallowed characters: <>:\"/\\|?*\t\n\r )");
+		ImGui::SetTooltip(R"(Disallowed characters: <>:\"/\\|?*\t\n\r
+Separate names with commas to create several instances at once)");
 
 	ImGui::PopItemWidth();
 
 	ImGui::SameLine();
 
 	if (ui::ConditionalButton("Create instance", !(instanceNameBuf.empty() || StringUtils::ContainsOnly(instanceNameBuf, '\0')), ui::ButtonStyle::Green)) {
-		CoreLogger::Log(LogLevel::INFO, "Creating instance...");
-
-		auto completionCallback = [=]() {
-			CoreLogger::Log(LogLevel::INFO, "Instance created");
-			std::vector<std::string> new_instances = Roblox::GetNewInstances(g_InstanceNames);
-
-			for (const auto& str: new_instances) {
-				auto pos = std::lower_bound(g_InstanceNames.begin(), g_InstanceNames.end(), str,
-				                            [](const std::string& a, const std::string& b) {
-					                            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
-					                                                                [](char ca, char cb) {
-						                                                                return std::tolower(ca) < std::tolower(cb);
-					                                                                });
-				                            });
-
-				g_InstanceNames.insert(pos, str);
+		std::vector<std::string> names;
+		for (const auto& part: instanceNameBuf | std::views::split(',')) {
+			if (std::string name(part.begin(), part.end()); !name.empty()) {
+				names.push_back(std::move(name));
 			}
+		}
+
+		CoreLogger::Log(LogLevel::INFO, "Creating {} instance(s)...", names.size());
 
-			g_Selection.resize(g_InstanceNames.size(), false);
+		auto completionCallback = [this]() {
+			CoreLogger::Log(LogLevel::INFO, "Instances created");
+			QueueListEdit(AddNewInstances);
 		};
 
-		this->m_QueuedThreadPool.SubmitTask(completionCallback, []() {
-			g_InstanceControl.CreateInstance(instanceNameBuf);
+		// Copied from the template, so it waits for any template update in flight
+		this->m_Lanes.SubmitBehind(names, {"template"}, completionCallback, [names]() {
+			g_InstanceControl.CreateInstances(names);
 		});
 	}
 }
@@ -475,8 +529,8 @@ void InstanceManager::RenderUpdateTemplate() {
 			std::filesystem::create_directories("Template\\Assets");
 		}
 
-		this->m_QueuedThreadPool.SubmitTask(callback, []() {
-			Utils::UpdatePackage("Template");
+		this->m_Lanes.SubmitTask({"template"}, callback, []() {
+			Utils::UpdateTemplate("Template");
 		});
 	}
 }
@@ -487,22 +541,92 @@ void InstanceManager::RenderUpdateInstance() {
 		return;
 
 	if (ImGui::Button("Update Instance")) {
+		CoreLogger::Log(LogLevel::INFO, "Updating template...");
+
+		// Instances are refreshed from the local template, so it has to be current first
+		this->m_Lanes.SubmitTask({"template"}, []() {
+			Utils::UpdateTemplate("Template");
+		});
+
 		Utils::ForEachSelectedInstance(g_Selection, [this](int idx) {
-			auto callback = [idx]() {
-				std::string abs_path = std::filesystem::absolute(g_InstanceControl.GetInstance(g_InstanceNames[idx]).InstallLocation + "\\AppxManifest.xml").string();
+			const std::string name = g_InstanceNames[idx];
+			// Behind the template update but not holding its lane, so the instances update side by side
+			this->m_Lanes.SubmitBehind({name}, {"template"}, nullptr, [name]() {
+				CoreLogger::Log(LogLevel::INFO, "Updating {}...", name);
+				const std::string& location = g_InstanceControl.GetInstance(name).InstallLocation;
+
+				Utils::InstanceUpdate result = Utils::InstanceUpdate::Failed;
+				try {
+					result = Utils::UpdateInstance("Template", location, name);
+				} catch (const std::exception& e) {
+					CoreLogger::Log(LogLevel::ERR, "Error updating {}: {}", name, e.what());
+				}
+
+				if (result == Utils::InstanceUpdate::AlreadyCurrent) {
+					return;
+				}
+
+				if (result == Utils::InstanceUpdate::Failed) {
+					CoreLogger::Log(LogLevel::WARNING, "Block update of {} failed, downloading the full package", name);
+					Utils::UpdatePackage(location, name);
+				}
+
+				std::string abs_path = std::filesystem::absolute(location + "\\AppxManifest.xml").string();
 				std::string cmd = "Add-AppxPackage -path '" + abs_path + "' -register";
 				Native::RunPowershellCommand<false>(cmd);
 				CoreLogger::Log(LogLevel::INFO, "Update Done");
-			};
-			this->m_QueuedThreadPool.SubmitTask(callback, [idx]() {
-				CoreLogger::Log(LogLevel::INFO, "Updating {}...", g_InstanceNames[idx]);
-				Utils::UpdatePackage(g_InstanceControl.GetInstance(g_InstanceNames[idx]).InstallLocation, g_InstanceNames[idx]);
 			});
 		});
 		ImGui::CloseCurrentPopup();
 	}
 }
 
+void InstanceManager::RenderVerifyInstances() {
+	if (!AnyInstanceSelected())
+		return;
+
+	static bool repair = false;
+
+	if (ImGui::Button("Verify Files")) {
+		std::vector<std::filesystem::path> locations;
+		std::vector<std::string> lanes;
+		Utils::ForEachSelectedInstance(g_Selection, [&locations, &lanes](int idx) {
+			locations.emplace_back(g_InstanceControl.GetInstance(g_InstanceNames[idx]).InstallLocation);
+			lanes.push_back(g_InstanceNames[idx]);
+		});
+
+		CoreLogger::Log(LogLevel::INFO, "Verifying {} instance(s)...", locations.size());
+
+		// Queued behind creates and updates of these instances, so the scan never reads files that are still being
+		// written, and behind template updates, since repairs copy from the template
+		this->m_Lanes.SubmitBehind(std::move(lanes), {"template"}, nullptr, [locations, repairFiles = repair]() {
+			Appx::IntegrityScanner scanner;
+			for (const auto& report: scanner.Scan(locations)) {
+				const std::string name = report.PackageDir.filename().string();
+
+				if (report.IsClean()) {
+					CoreLogger::Log(LogLevel::INFO, "{}: all {} files intact", name, report.FilesChecked);
+					continue;
+				}
+
+				CoreLogger::Log(LogLevel::WARNING, "{}: {} of {} files are missing or damaged", name, report.Issues.size(), report.FilesChecked);
+				for (const auto& issue: report.Issues) {
+					CoreLogger::Log(LogLevel::DEBUG, "{}: {}", name, issue.File.Name);
+				}
+
+				if (repairFiles) {
+					Appx::IntegrityScanner::Repair(report, "Template");
+				}
+			}
+		});
+		ImGui::CloseCurrentPopup();
+	}
+
+	ImGui::SameLine();
+
+	ImGui::Checkbox("Repair", &repair);
+}
+
 bool InstanceManager::AnyInstanceSelected() {
 	return std::any_of(g_Selection.begin(), g_Selection.end(), [](bool selected) { return selected; });
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "utils/Utils.hpp"
 
+#include <charconv>
 #include <filesystem>
 #include <fstream>
+#include <optional>
 #include <thread>
 #define NOMINMAX
 #include <windows.h>
@@ -11,6 +13,10 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "appx/BlockMap.h"
+#include "appx/ContentStore.h"
+#include "appx/DeltaUpdate.h"
+#include "appx/TemplateImage.h"
 #include "cpr/cpr.h"
 #include "logging/CoreLogger.hpp"
 #include "tinyxml2.h"
@@ -21,69 +27,6 @@
 #include "stb_image_write.h"
 
 namespace Utils {
-	std::vector<unsigned char> ParsePattern(const std::string& patternString) {
-		std::vector<unsigned char> pattern;
-		size_t start = 0;
-		size_t end = patternString.find(' ');
-
-		while (end != std::string::npos) {
-			std::string byteString = patternString.substr(start, end - start);
-			if (byteString == "??") {
-				pattern.push_back('?');
-			} else {
-				unsigned long byteValue = std::strtol(byteString.c_str(), nullptr, 16);
-				pattern.push_back(static_cast<unsigned char>(byteValue));
-			}
-			start = end + 1;
-			end = patternString.find(' ', start);
-		}
-
-		// Handle the last token in the string (after the last space)
-		std::string byteString = patternString.substr(start, end);
-		if (byteString == "??") {
-			pattern.push_back('?');
-		} else {
-			unsigned long byteValue = std::strtol(byteString.c_str(), nullptr, 16);
-			pattern.push_back(static_cast<unsigned char>(byteValue));
-		}
-
-		return pattern;
-	}
-
-	uintptr_t BoyerMooreHorspool(const unsigned char* signature, size_t signatureSize, const unsigned char* data, size_t dataSize) {
-		size_t maxShift = signatureSize;
-		size_t maxIndex = signatureSize - 1;
-		size_t wildCardIndex = 0;
-		for (size_t i = 0; i < maxIndex; i++) {
-			if (signature[i] == '?') {
-				maxShift = maxIndex - i;
-				wildCardIndex = i;
-			}
-		}
-
-		size_t shiftTable[256];
-		for (size_t i = 0; i <= 255; i++) {
-			shiftTable[i] = maxShift;
-		}
-
-		for (size_t i = wildCardIndex + 1; i < maxIndex - 1; i++) {
-			shiftTable[signature[i]] = maxIndex - i;
-		}
-
-		for (size_t currentIndex = 0; currentIndex < dataSize - signatureSize;) {
-			for (size_t sigIndex = maxIndex; sigIndex >= 0; sigIndex--) {
-				if (data[currentIndex + sigIndex] != signature[sigIndex] && signature[sigIndex] != '?') {
-					currentIndex += shiftTable[data[currentIndex + maxIndex]];
-					break;
-				} else if (sigIndex == 0) {
-					return currentIndex;
-				}
-			}
-		}
-
-		return 0;
-	}
-
 	void DownloadAndSave(const std::string& url, const std::string& localFileName) {
 		std::ofstream out(localFileName, std::ios::binary);
 		cpr::Response r = cpr::Download(out, cpr::Url{url});
@@ -179,16 +122,20 @@ namespace Utils {
 	}
 
 	void UpdatePackage(const std::string& baseFolder, const std::string& instanceName) {
+		// Every package downloads into a folder of its own, several instances can fall back to this at the same time
+		const std::filesystem::path downloads = std::filesystem::temp_directory_path() / fmt::format("Instance-Manager-{:016x}", std::hash<std::string>{}(std::filesystem::absolute(baseFolder).string()));
+		std::filesystem::create_directories(downloads);
+
 		// For Windows10Universal.zip
-		std::thread win10t([baseFolder]() {
-			DownloadAndSave("https://raw.githubusercontent.com/Sightem/Instance-Manager/master/Template/Windows10Universal.zip", "Windows10Universal.zip");
-			DecompressZip("Windows10Universal.zip", baseFolder + "\\Windows10Universal.exe");
+		std::thread win10t([baseFolder, zip = (downloads / "Windows10Universal.zip").string()]() {
+			DownloadAndSave("https://raw.githubusercontent.com/Sightem/Instance-Manager/master/Template/Windows10Universal.zip", zip);
+			DecompressZip(zip, baseFolder + "\\Windows10Universal.exe");
 		});
 
 		// For CrashHandler.exe
-		std::thread crasht([baseFolder]() {
-			DownloadAndSave("https://raw.githubusercontent.com/Sightem/Instance-Manager/master/Template/Assets/CrashHandler.exe", "CrashHandler.exe");
-			CopyFileToDestination("CrashHandler.exe", baseFolder + "\\Assets\\CrashHandler.exe");
+		std::thread crasht([baseFolder, exe = (downloads / "CrashHandler.exe").string()]() {
+			DownloadAndSave("https://raw.githubusercontent.com/Sightem/Instance-Manager/master/Template/Assets/CrashHandler.exe", exe);
+			CopyFileToDestination(exe, baseFolder + "\\Assets\\CrashHandler.exe");
 		});
 
 		// For AppxManifest.xml
@@ -207,6 +154,187 @@ namespace Utils {
 		appxt.join();
 
 		CoreLogger::Log(LogLevel::INFO, "Updated AppxManifest");
+
+		std::error_code ec;
+		std::filesystem::remove_all(downloads, ec);
+	}
+
+	std::string ReadPackageVersion(const std::filesystem::path& manifestPath) {
+		tinyxml2::XMLDocument doc;
+		if (doc.LoadFile(manifestPath.string().c_str()) != tinyxml2::XML_SUCCESS) {
+			return "unknown";
+		}
+
+		tinyxml2::XMLElement* package = doc.FirstChildElement("Package");
+		tinyxml2::XMLElement* identity = package ? package->FirstChildElement("Identity") : nullptr;
+		const char* version = identity ? identity->Attribute("Version") : nullptr;
+		return version ? version : "unknown";
+	}
+
+	// Package versions are dot separated numbers, compared number by number
+	std::optional<std::vector<uint64_t>> ParseVersion(const std::string& text) {
+		std::vector<uint64_t> parts;
+		const char* it = text.data();
+		const char* end = it + text.size();
+		while (true) {
+			uint64_t part;
+			auto [next, ec] = std::from_chars(it, end, part);
+			if (ec != std::errc()) {
+				return std::nullopt;
+			}
+			parts.push_back(part);
+
+			if (next == end) {
+				return parts;
+			}
+			if (*next != '.') {
+				return std::nullopt;
+			}
+			it = next + 1;
+		}
+	}
+
+	bool UpdateTemplate(const std::string& templateFolder) {
+		static constexpr const char* TEMPLATE_URL = "https://raw.githubusercontent.com/Sightem/Instance-Manager/master/Template";
+
+		const std::filesystem::path storeRoot = "Store";
+		const std::filesystem::path staging = storeRoot / "staging";
+		std::filesystem::create_directories(staging);
+
+		Appx::ContentStore store(storeRoot);
+
+		// Seed the store with what the template already has, so only files whose hash changed get downloaded
+		if (auto current = Appx::ParseBlockMap(std::filesystem::path(templateFolder) / "AppxBlockMap.xml")) {
+			std::erase_if(*current, Appx::IsPerInstanceFile);
+			if (size_t imported = store.Import(templateFolder, *current); imported > 0) {
+				CoreLogger::Log(LogLevel::INFO, "Added {} template files to the store", imported);
+			}
+		}
+
+		DownloadAndSave(fmt::format("{}/AppxBlockMap.xml", TEMPLATE_URL), (staging / "AppxBlockMap.xml").string());
+		DownloadAndSave(fmt::format("{}/AppxManifest.xml", TEMPLATE_URL), (staging / "AppxManifest.xml").string());
+
+		auto files = Appx::ParseBlockMap(staging / "AppxBlockMap.xml");
+		if (!files) {
+			CoreLogger::Log(LogLevel::ERR, "Failed to download the template block map");
+			return false;
+		}
+
+		// The manifest is taken from the download as it is, the store could never verify it
+		std::erase_if(*files, Appx::IsPerInstanceFile);
+
+		size_t downloads = 0;
+		std::vector<Appx::BlockMapFile> failed = store.Fetch(*files, [&downloads](const Appx::BlockMapFile& file, const std::filesystem::path& destination) {
+			CoreLogger::Log(LogLevel::INFO, "Downloading {}...", file.Name);
+			++downloads;
+
+			// The repository ships the client executable zipped
+			if (file.Name == "Windows10Universal.exe") {
+				DownloadAndSave(fmt::format("{}/Windows10Universal.zip", TEMPLATE_URL), "Windows10Universal.zip");
+				return FS::DecompressZipToFile("Windows10Universal.zip", destination.string());
+			}
+
+			// The repository stores the encoded file names, which have to be escaped once more in the url
+			std::string urlPath = Appx::EncodeName(Appx::EncodeName(file.Name));
+			std::ranges::replace(urlPath, '\\', '/');
+			DownloadAndSave(fmt::format("{}/{}", TEMPLATE_URL, urlPath), destination.string());
+			return true;
+		});
+
+		CoreLogger::Log(LogLevel::INFO, "Downloaded {} of {} template files", downloads - failed.size(), files->size());
+
+		// A template with the new manifest but the old client would pass for up to date, so it is left alone
+		for (const auto& file: failed) {
+			if (file.Name == "Windows10Universal.exe" || file.Name == "Assets\\CrashHandler.exe") {
+				CoreLogger::Log(LogLevel::ERR, "Failed to download {}, the template was not updated", file.Name);
+				return false;
+			}
+		}
+
+		// Anything else that failed keeps the copy the template already has
+		if (!failed.empty()) {
+			CoreLogger::Log(LogLevel::WARNING, "Keeping the current copy of {} template files that failed to download", failed.size());
+			std::erase_if(*files, [&failed](const Appx::BlockMapFile& file) {
+				return std::ranges::find(failed, file.Name, &Appx::BlockMapFile::Name) != failed.end();
+			});
+		}
+
+		const std::string version = ReadPackageVersion(staging / "AppxManifest.xml");
+
+		// A version folder is a complete snapshot, so it is only written when nothing had to be kept from before
+		std::vector<std::filesystem::path> folders = {templateFolder};
+		if (failed.empty()) {
+			folders.push_back(storeRoot / "versions" / version);
+		}
+
+		for (const auto& folder: folders) {
+			if (!store.Materialize(*files, folder)) {
+				return false;
+			}
+
+			// Replaced rather than overwritten, instances cloned with hardlinks share the template's copies
+			for (const char* name: {"AppxBlockMap.xml", "AppxManifest.xml"}) {
+				CopyFileToDestination((staging / name).string(), (folder / name).string());
+			}
+		}
+
+		// Instance creation in image mode reads from the packed copy instead of thousands of small files
+		if (!Appx::TemplateImage::Build(templateFolder, Appx::TemplateImage::ImagePathFor(templateFolder))) {
+			CoreLogger::Log(LogLevel::WARNING, "Failed to pack the template, instances will be created from the folder");
+		}
+
+		CoreLogger::Log(LogLevel::INFO, "Template is at version {}", version);
+		return true;
+	}
+
+	// Brings an instance up to the template's client. The executables are refreshed block by block, so only the
+	// 64 KB blocks that changed between versions get written.
+	InstanceUpdate UpdateInstance(const std::string& templateFolder, const std::string& instanceFolder, const std::string& instanceName) {
+		const std::filesystem::path templatePath = templateFolder;
+		const std::filesystem::path instancePath = instanceFolder;
+
+		const std::string templateVersion = ReadPackageVersion(templatePath / "AppxManifest.xml");
+		const std::string instanceVersion = ReadPackageVersion(instancePath / "AppxManifest.xml");
+		auto templateParts = ParseVersion(templateVersion);
+		auto instanceParts = ParseVersion(instanceVersion);
+		if (!templateParts || !instanceParts) {
+			CoreLogger::Log(LogLevel::WARNING, "Couldn't compare the template's version {} with {} of {}", templateVersion, instanceVersion, instanceName);
+			return InstanceUpdate::Failed;
+		}
+
+		// Also what a template that failed to update looks like, there is nothing newer to refresh the instance to
+		if (*templateParts <= *instanceParts) {
+			CoreLogger::Log(LogLevel::INFO, "{} is already at version {}", instanceName, instanceVersion);
+			return InstanceUpdate::AlreadyCurrent;
+		}
+
+		auto files = Appx::ParseBlockMap(templatePath / "AppxBlockMap.xml");
+		if (!files) {
+			return InstanceUpdate::Failed;
+		}
+
+		for (const char* name: {"Windows10Universal.exe", "Assets\\CrashHandler.exe"}) {
+			auto it = std::ranges::find(*files, std::string(name), &Appx::BlockMapFile::Name);
+			if (it == files->end()) {
+				CoreLogger::Log(LogLevel::ERR, "{} is missing from the template block map", name);
+				return InstanceUpdate::Failed;
+			}
+
+			auto stats = Appx::RefreshFile(Appx::ResolvePath(templatePath, *it), Appx::ResolvePath(instancePath, *it), *it);
+			if (!stats) {
+				return InstanceUpdate::Failed;
+			}
+
+			CoreLogger::Log(LogLevel::INFO, "Updated {}, {} of {} blocks changed", name, stats->BlocksWritten, stats->BlocksTotal);
+		}
+
+		// In hardlink mode the block map is the template's own file, copying over it would be copying it onto itself
+		CopyFileToDestination((templatePath / "AppxBlockMap.xml").string(), (instancePath / "AppxBlockMap.xml").string());
+		CopyFileToDestination((templatePath / "AppxManifest.xml").string(), (instancePath / "AppxManifest.xml").string());
+		Utils::ModifyAppxManifest(instancePath / "AppxManifest.xml", instanceName);
+
+		CoreLogger::Log(LogLevel::INFO, "Updated AppxManifest");
+		return InstanceUpdate::Updated;
 	}
 
 	bool SaveScreenshotAsPng(const char* filename) {
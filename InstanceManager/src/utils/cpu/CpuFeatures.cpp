@@ -0,0 +1,69 @@
+#include "utils/cpu/CpuFeatures.h"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	void Cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]) {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for (int i = 0; i < 4; ++i) {
+			regs[i] = static_cast<uint32_t>(info[i]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	// AVX state has to be enabled by the OS as well, not just supported by the CPU
+	bool OsSavesYmm() {
+#if defined(_MSC_VER)
+		return (_xgetbv(0) & 0x6) == 0x6;
+#else
+		uint32_t eax, edx;
+		__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (eax & 0x6) == 0x6;
+#endif
+	}
+
+	CpuFeatures Detect() {
+		CpuFeatures features;
+
+		uint32_t regs[4];
+		Cpuid(0, 0, regs);
+		const uint32_t maxLeaf = regs[0];
+
+		Cpuid(1, 0, regs);
+		features.Sse2 = (regs[3] >> 26) & 1;
+		features.Ssse3 = (regs[2] >> 9) & 1;
+		features.Sse41 = (regs[2] >> 19) & 1;
+		const bool osxsave = (regs[2] >> 27) & 1;
+		const bool avx = (regs[2] >> 28) & 1;
+
+		if (maxLeaf >= 7) {
+			Cpuid(7, 0, regs);
+			features.Avx2 = avx && osxsave && OsSavesYmm() && ((regs[1] >> 5) & 1);
+			features.Sha = (regs[1] >> 29) & 1;
+		}
+
+		return features;
+	}
+#else
+	CpuFeatures Detect() {
+		return {};
+	}
+#endif
+}// namespace
+
+const CpuFeatures& CpuFeatures::Get() {
+	static const CpuFeatures features = Detect();
+	return features;
+}
@@ -0,0 +1,147 @@
+#include "utils/filesystem/DeletionService.h"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <ranges>
+#include <vector>
+
+#include "logging/CoreLogger.hpp"
+
+DeletionService::DeletionService() : m_UnlinkPool(IO_BUDGET) {
+	m_WorkerThread = std::thread(&DeletionService::Worker, this);
+}
+
+DeletionService::~DeletionService() {
+	{
+		std::scoped_lock lock(m_QueueMutex);
+		m_Stop = true;
+	}
+	m_Condition.notify_one();
+	m_WorkerThread.join();
+}
+
+void DeletionService::Enqueue(const std::filesystem::path& path, bool moveToTrash, CompletionCallback onComplete) {
+	Job job{path, path.filename().string(), std::move(onComplete)};
+
+	if (moveToTrash) {
+		auto trash = path.parent_path() / ".trash";
+		auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+		auto target = trash / fmt::format("{}-{}", path.filename().string(), stamp);
+
+		std::error_code ec;
+		std::filesystem::create_directories(trash, ec);
+		std::filesystem::rename(path, target, ec);
+
+		if (ec) {
+			CoreLogger::Log(LogLevel::WARNING, "Could not move {} to the trash, deleting it in place: {}", path.string(), ec.message());
+		} else {
+			job.path = std::move(target);
+		}
+	}
+
+	{
+		std::scoped_lock lock(m_QueueMutex);
+		m_Queue.push(std::move(job));
+	}
+	m_Condition.notify_one();
+}
+
+// Queues whatever a previous run left in the trash
+void DeletionService::EmptyTrash(const std::filesystem::path& parent) {
+	std::error_code ec;
+	for (const auto& entry: std::filesystem::directory_iterator(parent / ".trash", ec)) {
+		Enqueue(entry.path(), false);
+	}
+}
+
+size_t DeletionService::Pending() {
+	std::scoped_lock lock(m_QueueMutex);
+	return m_Queue.size();
+}
+
+void DeletionService::Worker() {
+	while (true) {
+		Job job;
+
+		{
+			std::unique_lock lock(m_QueueMutex);
+			m_Condition.wait(lock, [this] { return m_Stop || !m_Queue.empty(); });
+
+			if (m_Stop) return;
+
+			job = std::move(m_Queue.front());
+			m_Queue.pop();
+		}
+
+		bool success = DeleteTree(job);
+		if (job.onComplete) {
+			job.onComplete(success);
+		}
+	}
+}
+
+bool DeletionService::DeleteTree(const Job& job) {
+	std::error_code ec;
+	if (!std::filesystem::exists(job.path, ec)) {
+		CoreLogger::Log(LogLevel::ERR, "Error: Path does not exist.");
+		return false;
+	}
+
+	std::vector<std::filesystem::path> files;
+	std::vector<std::filesystem::path> directories;
+
+	for (auto it = std::filesystem::recursive_directory_iterator(job.path, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		if (it->is_directory() && !it->is_symlink()) {
+			directories.push_back(it->path());
+		} else {
+			files.push_back(it->path());
+		}
+	}
+
+	CoreLogger::Log(LogLevel::INFO, "Deleting {} ({} files)...", job.label, files.size());
+
+	std::atomic<size_t> removed = 0;
+	std::atomic<size_t> failed = 0;
+	std::atomic<size_t> nextReport = files.size() / 4;
+
+	std::vector<std::future<void>> batches;
+	for (size_t begin = 0; begin < files.size(); begin += FILES_PER_TASK) {
+		size_t end = std::min(begin + FILES_PER_TASK, files.size());
+
+		batches.push_back(m_UnlinkPool.SubmitTask([&, begin, end]() {
+			for (size_t i = begin; i < end; ++i) {
+				std::error_code removeError;
+				if (!std::filesystem::remove(files[i], removeError)) {
+					++failed;
+					continue;
+				}
+
+				size_t done = ++removed;
+				size_t report = nextReport.load();
+				if (done >= report && report > 0 && nextReport.compare_exchange_strong(report, report + files.size() / 4)) {
+					CoreLogger::Log(LogLevel::INFO, "Deleting {}: {}/{} files", job.label, done, files.size());
+				}
+			}
+		}));
+	}
+
+	for (auto& batch: batches) {
+		batch.get();
+	}
+
+	// Children were listed after their parents, so going backwards empties every directory before it is removed
+	for (auto& directory: std::ranges::reverse_view(directories)) {
+		std::filesystem::remove(directory, ec);
+	}
+
+	bool success = std::filesystem::remove(job.path, ec) && failed == 0;
+	if (success) {
+		CoreLogger::Log(LogLevel::INFO, "Deleted {} ({} files)", job.label, removed.load());
+	} else {
+		CoreLogger::Log(LogLevel::ERR, "Failed to delete {}, {} files could not be removed", job.label, failed.load());
+	}
+
+	return success;
+}
@@ -0,0 +1,130 @@
+#include "utils/filesystem/DirectoryIndex.h"
+
+#include "logging/CoreLogger.hpp"
+
+DirectoryIndex::DirectoryIndex(std::filesystem::path root) : m_Root(std::move(root)) {
+	StartWatching();
+}
+
+DirectoryIndex::~DirectoryIndex() {
+	StopWatching();
+}
+
+DirectoryIndex::Listing DirectoryIndex::List(const std::filesystem::path& directory) {
+	const std::string key = directory.string();
+
+	{
+		std::scoped_lock lock(m_Mutex);
+		auto it = m_Listings.find(key);
+		if (it != m_Listings.end() && !m_Dirty.contains(key)) {
+			return it->second;
+		}
+		m_Dirty.erase(key);
+	}
+
+	// A change that lands while the directory is being read marks it dirty again, so nothing is lost
+	Listing listing = ReadDirectory(directory);
+
+	std::scoped_lock lock(m_Mutex);
+	m_Listings[key] = listing;
+	return listing;
+}
+
+void DirectoryIndex::Invalidate() {
+	std::scoped_lock lock(m_Mutex);
+	m_Listings.clear();
+	m_Dirty.clear();
+}
+
+DirectoryIndex::Listing DirectoryIndex::ReadDirectory(const std::filesystem::path& directory) {
+	auto entries = std::make_shared<std::vector<Entry>>();
+
+	std::error_code ec;
+	for (const auto& entry: std::filesystem::directory_iterator(directory, ec)) {
+		Entry info;
+		info.path = entry.path();
+		info.filename = entry.path().filename().string();
+		info.uniqueId = directory.string() + "/" + info.filename;
+		info.isDirectory = entry.is_directory(ec);
+		info.isRegularFile = entry.is_regular_file(ec);
+
+		entries->push_back(std::move(info));
+	}
+
+	if (ec) {
+		CoreLogger::Log(LogLevel::ERR, "Error: {}", ec.message());
+	}
+
+	return entries;
+}
+
+void DirectoryIndex::MarkDirty(const std::filesystem::path& directory) {
+	std::scoped_lock lock(m_Mutex);
+	m_Dirty.insert(directory.string());
+}
+
+void DirectoryIndex::StartWatching() {
+	m_DirectoryHandle = CreateFileW(m_Root.wstring().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (m_DirectoryHandle == INVALID_HANDLE_VALUE) {
+		CoreLogger::Log(LogLevel::WARNING, "Failed to watch {} for changes, error code: {}", m_Root.string(), GetLastError());
+		return;
+	}
+
+	m_StopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+	m_WatchThread = std::thread(&DirectoryIndex::WatchLoop, this);
+}
+
+void DirectoryIndex::StopWatching() {
+	m_Stop = true;
+
+	if (m_StopEvent) SetEvent(m_StopEvent);
+	if (m_WatchThread.joinable()) m_WatchThread.join();
+
+	if (m_DirectoryHandle != INVALID_HANDLE_VALUE) CloseHandle(m_DirectoryHandle);
+	if (m_StopEvent) CloseHandle(m_StopEvent);
+}
+
+void DirectoryIndex::WatchLoop() {
+	alignas(DWORD) std::byte buffer[64 * 1024];
+
+	OVERLAPPED overlapped{};
+	overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+	while (!m_Stop) {
+		ResetEvent(overlapped.hEvent);
+
+		constexpr DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME;
+		if (!ReadDirectoryChangesW(m_DirectoryHandle, buffer, sizeof(buffer), TRUE, filter, NULL, &overlapped, NULL)) {
+			CoreLogger::Log(LogLevel::WARNING, "Stopped watching {} for changes, error code: {}", m_Root.string(), GetLastError());
+			break;
+		}
+
+		HANDLE handles[] = {overlapped.hEvent, m_StopEvent};
+		if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+			DWORD ignored = 0;
+			CancelIoEx(m_DirectoryHandle, &overlapped);
+			GetOverlappedResult(m_DirectoryHandle, &overlapped, &ignored, TRUE);
+			break;
+		}
+
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(m_DirectoryHandle, &overlapped, &bytes, FALSE)) {
+			break;
+		}
+
+		// Notifications didn't fit the buffer, anything could have changed
+		if (bytes == 0) {
+			Invalidate();
+			continue;
+		}
+
+		for (auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer);; info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(reinterpret_cast<std::byte*>(info) + info->NextEntryOffset)) {
+			std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+			MarkDirty((m_Root / name).parent_path());
+
+			if (info->NextEntryOffset == 0) break;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
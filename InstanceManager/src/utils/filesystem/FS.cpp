@@ -7,9 +7,141 @@
 
 #include "libzippp/libzippp.h"
 #include "logging/CoreLogger.hpp"
+#include "utils/threadpool/ThreadPool.hpp"
 
 namespace FS {
-	bool CopyDirectory(const std::filesystem::path& src, const std::filesystem::path& dst) {
+	namespace {
+		constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+		bool CopyFileRange(const std::filesystem::path& src, const std::filesystem::path& dst, uint64_t offset, uint64_t length, CopyProgress* progress) {
+			std::ifstream in(src, std::ios::binary);
+			std::fstream out(dst, std::ios::binary | std::ios::in | std::ios::out);
+			if (!in || !out) {
+				return false;
+			}
+
+			in.seekg(static_cast<std::streamoff>(offset));
+			out.seekp(static_cast<std::streamoff>(offset));
+
+			std::vector<char> buffer(std::min<uint64_t>(length, COPY_BUFFER_SIZE));
+			while (length > 0) {
+				auto toRead = static_cast<std::streamsize>(std::min<uint64_t>(length, buffer.size()));
+				if (!in.read(buffer.data(), toRead) || !out.write(buffer.data(), toRead)) {
+					return false;
+				}
+
+				length -= toRead;
+				if (progress) progress->bytesCopied += toRead;
+			}
+
+			return static_cast<bool>(out.flush());
+		}
+	}// namespace
+
+	bool CopyDirectory(const std::filesystem::path& src, const std::filesystem::path& dst, const CopyOptions& options) {
+		auto abs_src = std::filesystem::absolute(src);
+		auto abs_dst = std::filesystem::absolute(dst);
+
+		if (!std::filesystem::exists(abs_src) || !std::filesystem::is_directory(abs_src)) {
+			CoreLogger::Log(LogLevel::WARNING, "Source directory {} does not exist or is not a directory.", abs_src.string());
+			return false;
+		}
+
+		struct FileJob {
+			std::filesystem::path src;
+			std::filesystem::path dst;
+			uint64_t size;
+		};
+
+		std::vector<std::filesystem::path> directories{abs_dst};
+		std::vector<FileJob> files;
+
+		for (const auto& entry: std::filesystem::recursive_directory_iterator(abs_src)) {
+			auto dst_path = abs_dst / entry.path().lexically_relative(abs_src);
+
+			if (entry.is_directory()) {
+				directories.push_back(std::move(dst_path));
+			} else if (entry.is_regular_file()) {
+				files.push_back({entry.path(), std::move(dst_path), entry.file_size()});
+			} else {
+				CoreLogger::Log(LogLevel::WARNING, "Skipping non-regular file {}", entry.path().string());
+			}
+		}
+
+		// Parents come before their children in iteration order, so the whole tree exists before any copy starts
+		for (const auto& directory: directories) {
+			std::filesystem::create_directories(directory);
+		}
+
+		if (options.progress) {
+			options.progress->filesTotal += files.size();
+			for (const auto& file: files) {
+				options.progress->bytesTotal += file.size;
+			}
+		}
+
+		const uint64_t chunkSize = std::max<uint64_t>(options.chunkSize, COPY_BUFFER_SIZE);
+		ThreadPool pool(std::max<size_t>(options.maxConcurrency, 1));
+		std::vector<std::future<bool>> results;
+		bool failed = false;// a file that couldn't be set up, nothing was queued for it
+
+		for (const auto& file: files) {
+			if (file.size <= chunkSize) {
+				results.push_back(pool.SubmitTask([&file, progress = options.progress]() {
+					try {
+						std::filesystem::copy_file(file.src, file.dst, std::filesystem::copy_options::overwrite_existing);
+					} catch (const std::filesystem::filesystem_error& e) {
+						CoreLogger::Log(LogLevel::ERR, "Error copying file {} to {}: {}", file.src.string(), file.dst.string(), e.what());
+						return false;
+					}
+
+					if (progress) {
+						progress->bytesCopied += file.size;
+						++progress->filesCopied;
+					}
+					return true;
+				}));
+				continue;
+			}
+
+			// Large files are preallocated once and then filled by several workers at different offsets
+			std::error_code ec;
+			std::ofstream(file.dst, std::ios::binary | std::ios::trunc).close();
+			std::filesystem::resize_file(file.dst, file.size, ec);
+			if (ec) {
+				CoreLogger::Log(LogLevel::ERR, "Error copying file {} to {}: {}", file.src.string(), file.dst.string(), ec.message());
+				failed = true;
+				continue;
+			}
+
+			auto remainingChunks = std::make_shared<std::atomic<uint64_t>>((file.size + chunkSize - 1) / chunkSize);
+			for (uint64_t offset = 0; offset < file.size; offset += chunkSize) {
+				uint64_t length = std::min(chunkSize, file.size - offset);
+				results.push_back(pool.SubmitTask([&file, offset, length, remainingChunks, progress = options.progress]() {
+					if (!CopyFileRange(file.src, file.dst, offset, length, progress)) {
+						CoreLogger::Log(LogLevel::ERR, "Error copying file {} to {}: failed at offset {}", file.src.string(), file.dst.string(), offset);
+						return false;
+					}
+
+					if (--*remainingChunks == 0 && progress) {
+						++progress->filesCopied;
+					}
+					return true;
+				}));
+			}
+		}
+
+		bool success = !failed;
+		for (auto& result: results) {
+			success &= result.get();
+		}
+
+		return success;
+	}
+
+	// Hardlinks every file of src into dst except the ones listed in privateFiles (relative to src), which get their own copy.
+	// Files that are rewritten in place must stay private, anything written through a link would show up in every instance.
+	bool CloneDirectory(const std::filesystem::path& src, const std::filesystem::path& dst, const std::vector<std::filesystem::path>& privateFiles) {
 		auto abs_src = std::filesystem::absolute(src);
 		auto abs_dst = std::filesystem::absolute(dst);
 
@@ -22,29 +154,51 @@ namespace FS {
 			std::filesystem::create_directories(abs_dst);
 		}
 
+		bool linksSupported = true;
+
 		auto dir_iter = std::filesystem::recursive_directory_iterator(abs_src);
 		return std::ranges::all_of(dir_iter, [&](const auto& entry) {
 			const auto& src_path = entry.path();
-			auto dst_path = abs_dst / src_path.lexically_relative(abs_src);
+			auto rel_path = src_path.lexically_relative(abs_src);
+			auto dst_path = abs_dst / rel_path;
 
 			if (entry.is_directory()) {
 				std::filesystem::create_directories(dst_path);
-			} else if (entry.is_regular_file()) {
-				try {
-					std::filesystem::copy_file(src_path, dst_path, std::filesystem::copy_options::overwrite_existing);
-				} catch (const std::filesystem::filesystem_error& e) {
-					CoreLogger::Log(LogLevel::ERR, "Error copying file {} to {}: {}", src_path.string(), dst_path.string(), e.what());
-					return false;
-				}
-			} else {
+				return true;
+			} else if (!entry.is_regular_file()) {
 				CoreLogger::Log(LogLevel::WARNING, "Skipping non-regular file {}", src_path.string());
-				return true;// Consider skipping as successful to allow the rest of the files to be copied.
+				return true;
+			}
+
+			std::error_code ec;
+			std::filesystem::remove(dst_path, ec);
+
+			bool isPrivate = std::ranges::find(privateFiles, rel_path) != privateFiles.end();
+			if (!isPrivate && linksSupported) {
+				std::filesystem::create_hard_link(src_path, dst_path, ec);
+				if (!ec) {
+					return true;
+				}
+
+				// Volume can't link at all (FAT, network share, different drive), stop trying for the rest of the tree
+				if (ec == std::errc::cross_device_link || ec == std::errc::not_supported || ec == std::errc::function_not_supported || ec == std::errc::operation_not_supported) {
+					CoreLogger::Log(LogLevel::WARNING, "Hardlinks are not supported from {} to {}, falling back to a full copy: {}", abs_src.string(), abs_dst.string(), ec.message());
+					linksSupported = false;
+				} else {
+					CoreLogger::Log(LogLevel::WARNING, "Failed to hardlink {}, copying it instead: {}", src_path.string(), ec.message());
+				}
+			}
+
+			try {
+				std::filesystem::copy_file(src_path, dst_path, std::filesystem::copy_options::overwrite_existing);
+			} catch (const std::filesystem::filesystem_error& e) {
+				CoreLogger::Log(LogLevel::ERR, "Error copying file {} to {}: {}", src_path.string(), dst_path.string(), e.what());
+				return false;
 			}
 			return true;
 		});
 	}
 
-
 	bool RemovePath(const std::filesystem::path& path_to_delete) {
 		std::error_code ec;
 
@@ -69,7 +223,40 @@ namespace FS {
 		}
 	}
 
-	bool DecompressZip(const std::string& zipPath, const std::string& destination) {
+	// Flushes the file's data to disk, not just out of the process
+	bool SyncFile(const std::filesystem::path& path) {
+		HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		BOOL flushed = FlushFileBuffers(file);
+		CloseHandle(file);
+		return flushed != FALSE;
+	}
+
+	namespace {
+		constexpr size_t MIN_EXTRACT_CHUNK = 64 * 1024;
+		constexpr size_t MAX_EXTRACT_CHUNK = 1024 * 1024;// larger reads only cost memory, the disk is already kept busy
+
+		// Streams the entry into the file chunkSize bytes at a time instead of inflating all of it in memory first
+		bool ExtractEntry(const libzippp::ZipEntry& entry, const std::string& outputPath, size_t chunkSize) {
+			std::ofstream outputFile(outputPath, std::ios::binary);
+			if (!outputFile) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to write file: {}", outputPath);
+				return false;
+			}
+
+			if (entry.readContent(outputFile, libzippp::ZipArchive::Current, chunkSize) != LIBZIPPP_OK) {
+				CoreLogger::Log(LogLevel::ERR, "Failed to extract {} to {}", entry.getName(), outputPath);
+				return false;
+			}
+
+			return true;
+		}
+	}// namespace
+
+	bool DecompressZip(const std::string& zipPath, const std::string& destination, const ExtractOptions& options) {
 		using namespace libzippp;
 
 		ZipArchive zip(zipPath);
@@ -78,6 +265,8 @@ namespace FS {
 			return false;
 		}
 
+		// Directories are created up front, the files are then independent of each other
+		std::vector<int> fileEntries;
 
 		auto nbEntries = zip.getNbEntries();
 		for (int i = 0; i < nbEntries; ++i) {
@@ -88,21 +277,51 @@ namespace FS {
 				if (entry.isDirectory()) {
 					CreateDirectoryA(outputPath.c_str(), NULL);
 				} else {
-					std::string content = entry.readAsText();
-					std::ofstream outputFile(outputPath, std::ios::binary);
-					if (outputFile) {
-						outputFile.write(content.c_str(), content.size());
-						outputFile.close();
-					} else {
-						CoreLogger::Log(LogLevel::ERR, "Failed to write file: {}", outputPath);
-					}
+					fileEntries.push_back(i);
 				}
 			}
 		}
 
 		zip.close();
 
-		return true;
+		const size_t threads = std::clamp<size_t>(std::min(options.maxThreads, options.memoryCap / MIN_EXTRACT_CHUNK), 1, std::max<size_t>(fileEntries.size(), 1));
+		const size_t chunkSize = std::clamp(options.memoryCap / threads, MIN_EXTRACT_CHUNK, MAX_EXTRACT_CHUNK);
+
+		// libzip handles can't be shared between threads, every worker reads through its own
+		std::atomic<size_t> nextEntry{0};
+		ThreadPool pool(threads);
+		std::vector<std::future<bool>> results;
+
+		for (size_t t = 0; t < threads; ++t) {
+			results.push_back(pool.SubmitTask([&]() {
+				ZipArchive workerZip(zipPath);
+				if (!workerZip.open(ZipArchive::ReadOnly)) {
+					CoreLogger::Log(LogLevel::ERR, "Failed to open zip archive: {}", zipPath);
+					return false;
+				}
+
+				bool success = true;
+				for (size_t i = nextEntry++; i < fileEntries.size(); i = nextEntry++) {
+					ZipEntry entry = workerZip.getEntry(fileEntries[i]);
+					std::string outputPath = destination + "\\" + entry.getName();
+
+					std::error_code ec;
+					std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), ec);
+
+					success &= ExtractEntry(entry, outputPath, chunkSize);
+				}
+
+				workerZip.close();
+				return success;
+			}));
+		}
+
+		bool success = true;
+		for (auto& result: results) {
+			success &= result.get();
+		}
+
+		return success;
 	}
 
 	bool DecompressZipToFile(const std::string& zipPath, const std::string& destination) {
@@ -123,26 +342,17 @@ namespace FS {
 		}
 
 		ZipEntry entry = zip.getEntry(0);
-		if (!entry.isNull() && !entry.isDirectory()) {
-			std::string content = entry.readAsText();
-			std::ofstream outputFile(destination, std::ios::binary);
-			if (outputFile) {
-				outputFile.write(content.c_str(), content.size());
-				outputFile.close();
-			} else {
-				CoreLogger::Log(LogLevel::ERR, "Failed to write file: {}", destination);
-				zip.close();
-				return false;
-			}
-		} else {
+		if (entry.isNull() || entry.isDirectory()) {
 			CoreLogger::Log(LogLevel::ERR, "Invalid zip entry: {}", zipPath);
 			zip.close();
 			return false;
 		}
 
+		bool success = ExtractEntry(entry, destination, MAX_EXTRACT_CHUNK);
+
 		zip.close();
 
-		return true;
+		return success;
 	}
 
 	std::vector<std::string> FindFiles(const std::string& path, const std::string& substring) {
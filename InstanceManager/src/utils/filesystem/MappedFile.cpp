@@ -0,0 +1,119 @@
+#include "utils/filesystem/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		Close();
+		m_View = std::exchange(other.m_View, nullptr);
+		m_Size = std::exchange(other.m_Size, 0);
+		m_Identity = std::exchange(other.m_Identity, {});
+		m_IsOpen = std::exchange(other.m_IsOpen, false);
+#ifdef _WIN32
+		m_File = std::exchange(other.m_File, nullptr);
+		m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#else
+		m_Fd = std::exchange(other.m_Fd, -1);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	m_File = file;
+
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!GetFileInformationByHandle(file, &info)) {
+		Close();
+		return false;
+	}
+
+	m_Size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+	m_Identity = {info.dwVolumeSerialNumber, (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow};
+
+	if (m_Size > 0) {
+		m_Mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_Mapping == NULL) {
+			Close();
+			return false;
+		}
+
+		m_View = static_cast<const std::byte*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_View == nullptr) {
+			Close();
+			return false;
+		}
+	}
+#else
+	m_Fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_Fd < 0) {
+		return false;
+	}
+
+	struct stat info {};
+	if (fstat(m_Fd, &info) != 0) {
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast<uint64_t>(info.st_size);
+	m_Identity = {static_cast<uint64_t>(info.st_dev), static_cast<uint64_t>(info.st_ino)};
+
+	if (m_Size > 0) {
+		void* view = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, m_Fd, 0);
+		if (view == MAP_FAILED) {
+			Close();
+			return false;
+		}
+
+		madvise(view, m_Size, MADV_SEQUENTIAL);
+		m_View = static_cast<const std::byte*>(view);
+	}
+#endif
+
+	m_IsOpen = true;
+	return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (m_View != nullptr) {
+		UnmapViewOfFile(m_View);
+	}
+	if (m_Mapping != nullptr) {
+		CloseHandle(m_Mapping);
+	}
+	if (m_File != nullptr) {
+		CloseHandle(m_File);
+	}
+	m_File = nullptr;
+	m_Mapping = nullptr;
+#else
+	if (m_View != nullptr) {
+		munmap(const_cast<std::byte*>(m_View), m_Size);
+	}
+	if (m_Fd >= 0) {
+		close(m_Fd);
+	}
+	m_Fd = -1;
+#endif
+
+	m_View = nullptr;
+	m_Size = 0;
+	m_Identity = {};
+	m_IsOpen = false;
+}
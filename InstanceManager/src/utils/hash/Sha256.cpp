@@ -0,0 +1,207 @@
+#include "utils/hash/Sha256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "utils/cpu/CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SHA256_HAS_SHA_NI
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SHA_NI_TARGET
+#else
+#define SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
+
+namespace {
+	constexpr std::array<uint32_t, 64> K = {
+	        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+	constexpr uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+}// namespace
+
+void Sha256::Reset() {
+	m_State = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+	m_BufferSize = 0;
+	m_TotalSize = 0;
+}
+
+void Sha256::Update(const void* data, size_t size) {
+	auto bytes = static_cast<const uint8_t*>(data);
+	m_TotalSize += size;
+
+	if (m_BufferSize > 0) {
+		size_t take = std::min(size, m_Buffer.size() - m_BufferSize);
+		std::memcpy(m_Buffer.data() + m_BufferSize, bytes, take);
+		m_BufferSize += take;
+		bytes += take;
+		size -= take;
+
+		if (m_BufferSize < m_Buffer.size()) return;
+
+		Transform(m_Buffer.data(), 1);
+		m_BufferSize = 0;
+	}
+
+	if (size_t blocks = size / 64; blocks > 0) {
+		Transform(bytes, blocks);
+		bytes += blocks * 64;
+		size -= blocks * 64;
+	}
+
+	std::memcpy(m_Buffer.data(), bytes, size);
+	m_BufferSize = size;
+}
+
+Sha256::Digest Sha256::Final() {
+	uint64_t bitLength = m_TotalSize * 8;
+
+	static constexpr uint8_t padding[64] = {0x80};
+	Update(padding, m_BufferSize < 56 ? 56 - m_BufferSize : 120 - m_BufferSize);
+
+	uint8_t length[8];
+	for (int i = 0; i < 8; ++i) {
+		length[i] = static_cast<uint8_t>(bitLength >> (56 - 8 * i));
+	}
+	Update(length, sizeof(length));
+
+	Digest digest;
+	for (size_t i = 0; i < m_State.size(); ++i) {
+		digest[i * 4 + 0] = static_cast<uint8_t>(m_State[i] >> 24);
+		digest[i * 4 + 1] = static_cast<uint8_t>(m_State[i] >> 16);
+		digest[i * 4 + 2] = static_cast<uint8_t>(m_State[i] >> 8);
+		digest[i * 4 + 3] = static_cast<uint8_t>(m_State[i]);
+	}
+
+	Reset();
+	return digest;
+}
+
+Sha256::Digest Sha256::Hash(const void* data, size_t size) {
+	Sha256 sha;
+	sha.Update(data, size);
+	return sha.Final();
+}
+
+std::optional<Sha256::Digest> Sha256::HashFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return std::nullopt;
+	}
+
+	Sha256 sha;
+	std::vector<char> buffer(1024 * 1024);
+	while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount() > 0) {
+		sha.Update(buffer.data(), static_cast<size_t>(file.gcount()));
+	}
+
+	return sha.Final();
+}
+
+namespace {
+	void TransformScalar(uint32_t* state, const uint8_t* blocks, size_t count) {
+		for (; count > 0; --count, blocks += 64) {
+			uint32_t w[64];
+			for (int i = 0; i < 16; ++i) {
+				w[i] = (uint32_t(blocks[i * 4]) << 24) | (uint32_t(blocks[i * 4 + 1]) << 16) | (uint32_t(blocks[i * 4 + 2]) << 8) | uint32_t(blocks[i * 4 + 3]);
+			}
+			for (int i = 16; i < 64; ++i) {
+				uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+				uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+				w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+			}
+
+			uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+			uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+			for (int i = 0; i < 64; ++i) {
+				uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+				uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+				h = g;
+				g = f;
+				f = e;
+				e = d + t1;
+				d = c;
+				c = b;
+				b = a;
+				a = t1 + t2;
+			}
+
+			state[0] += a;
+			state[1] += b;
+			state[2] += c;
+			state[3] += d;
+			state[4] += e;
+			state[5] += f;
+			state[6] += g;
+			state[7] += h;
+		}
+	}
+
+#if defined(SHA256_HAS_SHA_NI)
+	// Intel SHA extensions, two rounds per sha256rnds2 with the state kept as ABEF/CDGH
+	SHA_NI_TARGET void TransformShaNi(uint32_t* state, const uint8_t* blocks, size_t count) {
+		const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+		__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+		__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+		__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+		state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+		for (; count > 0; --count, blocks += 64) {
+			const __m128i abefSave = state0;
+			const __m128i cdghSave = state1;
+
+			__m128i w[4];
+			for (int g = 0; g < 16; ++g) {
+				if (g < 4) {
+					w[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + g * 16)), byteSwap);
+				} else {
+					__m128i next = _mm_add_epi32(_mm_sha256msg1_epu32(w[g & 3], w[(g + 1) & 3]), _mm_alignr_epi8(w[(g + 3) & 3], w[(g + 2) & 3], 4));
+					w[g & 3] = _mm_sha256msg2_epu32(next, w[(g + 3) & 3]);
+				}
+
+				__m128i msg = _mm_add_epi32(w[g & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[g * 4])));
+				state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+				state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+			}
+
+			state0 = _mm_add_epi32(state0, abefSave);
+			state1 = _mm_add_epi32(state1, cdghSave);
+		}
+
+		tmp = _mm_shuffle_epi32(state0, 0x1B);
+		state1 = _mm_shuffle_epi32(state1, 0xB1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(tmp, state1, 0xF0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(state1, tmp, 8));
+	}
+#endif
+
+	using TransformFn = void (*)(uint32_t* state, const uint8_t* blocks, size_t count);
+
+	TransformFn SelectTransform() {
+#if defined(SHA256_HAS_SHA_NI)
+		const CpuFeatures& cpu = CpuFeatures::Get();
+		if (cpu.Sha && cpu.Sse41 && cpu.Ssse3) {
+			return TransformShaNi;
+		}
+#endif
+		return TransformScalar;
+	}
+}// namespace
+
+void Sha256::Transform(const uint8_t* blocks, size_t count) {
+	static const TransformFn transform = SelectTransform();
+	transform(m_State.data(), blocks, count);
+}
@@ -3,11 +3,70 @@
 #define NOMINMAX
 #include <windows.h>
 
+#include <cstring>
 #include <vector>
 
 namespace StringUtils {
+	constexpr const char* BASE64_ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 	bool ContainsOnly(const std::string& s, char c) {
 		return s.find_first_not_of(c) == std::string::npos;
 	}
 
-}// namespace StringUtils
\ No newline at end of file
+	std::string Base64Encode(std::span<const uint8_t> data) {
+		std::string result;
+		result.reserve((data.size() + 2) / 3 * 4);
+
+		for (size_t i = 0; i < data.size(); i += 3) {
+			uint32_t chunk = uint32_t(data[i]) << 16;
+			if (i + 1 < data.size()) chunk |= uint32_t(data[i + 1]) << 8;
+			if (i + 2 < data.size()) chunk |= uint32_t(data[i + 2]);
+
+			result += BASE64_ALPHABET[(chunk >> 18) & 0x3F];
+			result += BASE64_ALPHABET[(chunk >> 12) & 0x3F];
+			result += i + 1 < data.size() ? BASE64_ALPHABET[(chunk >> 6) & 0x3F] : '=';
+			result += i + 2 < data.size() ? BASE64_ALPHABET[chunk & 0x3F] : '=';
+		}
+
+		return result;
+	}
+
+	std::optional<std::vector<uint8_t>> Base64Decode(const std::string& s) {
+		std::vector<uint8_t> result;
+		result.reserve(s.size() / 4 * 3);
+
+		uint32_t chunk = 0;
+		int bits = 0;
+		for (char c: s) {
+			if (c == '=') break;
+
+			const char* pos = std::strchr(BASE64_ALPHABET, c);
+			if (c == '\0' || pos == nullptr) {
+				return std::nullopt;
+			}
+
+			chunk = (chunk << 6) | static_cast<uint32_t>(pos - BASE64_ALPHABET);
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				result.push_back(static_cast<uint8_t>(chunk >> bits));
+			}
+		}
+
+		return result;
+	}
+
+	std::string ToHex(std::span<const uint8_t> data) {
+		static constexpr const char* digits = "0123456789abcdef";
+
+		std::string result;
+		result.reserve(data.size() * 2);
+		for (uint8_t byte: data) {
+			result += digits[byte >> 4];
+			result += digits[byte & 0x0F];
+		}
+
+		return result;
+	}
+
+}// namespace StringUtils
@@ -0,0 +1,81 @@
+#include "utils/threadpool/LaneExecutor.hpp"
+
+#include <algorithm>
+
+LaneExecutor::~LaneExecutor() {
+	std::unique_lock lock(m_Mutex);
+	m_Idle.wait(lock, [this] { return m_Unfinished == 0; });
+}
+
+void LaneExecutor::Submit(std::shared_ptr<Job> job) {
+	// A lane named twice would wait on itself
+	std::ranges::sort(job->Lanes);
+	job->Lanes.erase(std::unique(job->Lanes.begin(), job->Lanes.end()), job->Lanes.end());
+
+	{
+		std::scoped_lock lock(m_Mutex);
+		++m_Unfinished;
+
+		// Queued on all its lanes under one lock, so every pair of lanes sees jobs in the same order and two jobs
+		// can never each wait on a lane the other one holds
+		for (const auto& lane: job->Lanes) {
+			auto& queue = m_Lanes[lane];
+			queue.push_back(job);
+			if (queue.size() > 1) {
+				++job->Waiting;
+			}
+		}
+
+		// Lanes run in order, so the last job queued on a lane finishes after everything before it
+		for (const auto& lane: job->Behind) {
+			auto it = m_Lanes.find(lane);
+			if (it != m_Lanes.end() && !std::ranges::binary_search(job->Lanes, lane)) {
+				it->second.back()->Dependents.push_back(job);
+				++job->Waiting;
+			}
+		}
+
+		if (job->Waiting > 0) {
+			return;
+		}
+	}
+
+	Run(std::move(job));
+}
+
+void LaneExecutor::Run(std::shared_ptr<Job> job) {
+	const auto delay = job->Delay;
+	m_Pool.PostAfter(delay, [this, job = std::move(job)]() {
+		job->Task();
+
+		std::vector<std::shared_ptr<Job>> ready;
+		{
+			std::scoped_lock lock(m_Mutex);
+			for (const auto& lane: job->Lanes) {
+				auto it = m_Lanes.find(lane);
+				it->second.pop_front();
+				if (it->second.empty()) {
+					m_Lanes.erase(it);
+				} else if (--it->second.front()->Waiting == 0) {
+					ready.push_back(it->second.front());
+				}
+			}
+
+			for (auto& dependent: job->Dependents) {
+				if (--dependent->Waiting == 0) {
+					ready.push_back(std::move(dependent));
+				}
+			}
+			job->Dependents.clear();
+		}
+
+		for (auto& next: ready) {
+			Run(std::move(next));
+		}
+
+		std::scoped_lock lock(m_Mutex);
+		if (--m_Unfinished == 0) {
+			m_Idle.notify_all();
+		}
+	});
+}
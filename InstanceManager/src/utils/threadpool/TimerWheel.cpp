@@ -0,0 +1,74 @@
+#include "utils/threadpool/TimerWheel.hpp"
+
+#include <algorithm>
+
+#include "utils/threadpool/BlockCache.hpp"
+
+TimerWheel::~TimerWheel() {
+	for (Timer* timer: m_Slots) {
+		while (timer) {
+			Timer* next = timer->Next;
+			BlockCache<sizeof(Timer)>::Deallocate(timer);
+			timer = next;
+		}
+	}
+}
+
+void TimerWheel::Add(Clock::time_point when, TaskWrapper* task) {
+	// Nothing pending, nothing to catch up on, the wheel can jump to the present
+	const Clock::time_point now = Clock::now();
+	if (m_Size == 0 && now > m_Epoch) {
+		m_Tick = std::max<uint64_t>(m_Tick, (now - m_Epoch) / TICK);
+	}
+
+	uint64_t tick = m_Tick + 1;
+	if (when > m_Epoch) {
+		const auto ticks = (when - m_Epoch + TICK - Clock::duration(1)) / TICK;
+		tick = std::max<uint64_t>(tick, ticks);
+	}
+
+	Timer*& slot = m_Slots[tick % SLOTS];
+	slot = new (BlockCache<sizeof(Timer)>::Allocate()) Timer{task, tick, slot};
+	++m_Size;
+}
+
+void TimerWheel::Advance(Clock::time_point now, std::vector<TaskWrapper*>& due) {
+	if (now <= m_Epoch) {
+		return;
+	}
+
+	const uint64_t target = (now - m_Epoch) / TICK;
+	if (target <= m_Tick) {
+		return;
+	}
+
+	// Past a full revolution every slot has been passed once, which is enough
+	const uint64_t steps = std::min<uint64_t>(target - m_Tick, SLOTS);
+	for (uint64_t step = 1; step <= steps && m_Size > 0; ++step) {
+		Timer** link = &m_Slots[(m_Tick + step) % SLOTS];
+		while (Timer* timer = *link) {
+			if (timer->Tick > target) {
+				link = &timer->Next;
+				continue;
+			}
+
+			*link = timer->Next;
+			due.push_back(timer->Task);
+			BlockCache<sizeof(Timer)>::Deallocate(timer);
+			--m_Size;
+		}
+	}
+
+	m_Tick = target;
+}
+
+void TimerWheel::Clear(std::vector<TaskWrapper*>& pending) {
+	for (Timer*& slot: m_Slots) {
+		while (Timer* timer = slot) {
+			slot = timer->Next;
+			pending.push_back(timer->Task);
+			BlockCache<sizeof(Timer)>::Deallocate(timer);
+		}
+	}
+	m_Size = 0;
+}
@@ -1,39 +1,186 @@
 #include "utils/threadpool/ThreadPool.hpp"
 
+#include <algorithm>
+
+namespace {
+	// Workers spin this many times through the queues before going to sleep
+	constexpr int IDLE_ROUNDS = 64;
+
+	// Which pool and worker the current thread is, if any
+	thread_local ThreadPool* t_Pool = nullptr;
+	thread_local size_t t_WorkerIndex = 0;
+}// namespace
+
 ThreadPool::ThreadPool(size_t num_threads) {
 	for (size_t i = 0; i < num_threads; ++i) {
-		workers.emplace_back([this] {
-			while (true) {
-				std::optional<TaskWrapper> task_opt;
-
-				{
-					std::unique_lock<std::mutex> lock(this->queue_mutex);
-
-					this->condition.wait(lock, [this] {
-						return this->stop ||
-						       (!this->tasks.empty());
-					});
-
-					if (this->stop && this->tasks.empty()) return;
-
-					task_opt = std::move(this->tasks.front());
-					this->tasks.pop();
-				}
-				if (task_opt) {
-					(*task_opt)();
-				}
-			}
-		});
+		queues.push_back(std::make_unique<WorkStealingDeque<TaskWrapper>>());
+	}
+
+	for (size_t i = 0; i < num_threads; ++i) {
+		workers.emplace_back([this, i] { WorkerLoop(i); });
 	}
 }
 
 ThreadPool::~ThreadPool() {
 	{
-		std::scoped_lock<std::mutex> lock(queue_mutex);
-		stop = true;
+		std::scoped_lock<std::mutex> lock(timer_mutex);
+		timer_stop = true;
+	}
+	timer_condition.notify_all();
+	if (timer_thread.joinable()) {
+		timer_thread.join();
+	}
+
+	std::vector<TaskWrapper*> dropped;
+	timers.Clear(dropped);
+	for (TaskWrapper* task: dropped) {
+		Release(task);
+	}
+
+	{
+		std::scoped_lock<std::mutex> lock(sleep_mutex);
+		stop.store(true);
 	}
 	condition.notify_all();
 	for (std::thread& worker: workers) {
 		worker.join();
 	}
-}
\ No newline at end of file
+}
+
+void ThreadPool::Schedule(TaskWrapper* task) {
+	// Counted before it is queued, so a worker never takes a task the count doesn't include yet
+	pending.fetch_add(1);
+
+	if (t_Pool == this) {
+		queues[t_WorkerIndex]->Push(task);
+	} else {
+		std::scoped_lock<std::mutex> lock(injection_mutex);
+		const size_t count = injected_count.load(std::memory_order_relaxed);
+		if (count == injected.size()) {
+			// Unwrapped into a ring twice the size
+			std::vector<TaskWrapper*> grown(std::max<size_t>(64, injected.size() * 2));
+			for (size_t i = 0; i < count; ++i) {
+				grown[i] = injected[(injected_head + i) % injected.size()];
+			}
+			injected = std::move(grown);
+			injected_head = 0;
+		}
+		injected[(injected_head + count) % injected.size()] = task;
+		injected_count.store(count + 1, std::memory_order_relaxed);
+	}
+
+	// A worker going to sleep registers before it checks pending, so either it sees this task or it is woken here
+	if (sleeping.load() > 0) {
+		{
+			std::scoped_lock<std::mutex> lock(sleep_mutex);
+		}
+		condition.notify_one();
+	}
+}
+
+void ThreadPool::ScheduleAt(Clock::time_point when, TaskWrapper* task) {
+	if (when <= Clock::now()) {
+		Schedule(task);
+		return;
+	}
+
+	{
+		std::scoped_lock<std::mutex> lock(timer_mutex);
+		if (!timer_thread.joinable()) {
+			timer_thread = std::thread([this] { TimerLoop(); });
+		}
+		timers.Add(when, task);
+	}
+	timer_condition.notify_one();
+}
+
+void ThreadPool::TimerLoop() {
+	std::vector<TaskWrapper*> due;
+
+	std::unique_lock<std::mutex> lock(timer_mutex);
+	while (!timer_stop) {
+		// Asleep until there is a timer, then awake once a tick while there are any
+		if (timers.Size() == 0) {
+			timer_condition.wait(lock, [this] { return timer_stop || timers.Size() > 0; });
+			continue;
+		}
+
+		if (timer_condition.wait_until(lock, timers.NextTick(), [this] { return timer_stop; })) {
+			break;
+		}
+
+		timers.Advance(Clock::now(), due);
+		if (!due.empty()) {
+			lock.unlock();
+			for (TaskWrapper* task: due) {
+				Schedule(task);
+			}
+			due.clear();
+			lock.lock();
+		}
+	}
+}
+
+void ThreadPool::Release(TaskWrapper* task) {
+	task->~TaskWrapper();
+	BlockCache<sizeof(TaskWrapper)>::Deallocate(task);
+}
+
+TaskWrapper* ThreadPool::FindTask(size_t index) {
+	if (TaskWrapper* task = queues[index]->Take()) {
+		return task;
+	}
+
+	if (injected_count.load(std::memory_order_relaxed) > 0) {
+		std::scoped_lock<std::mutex> lock(injection_mutex);
+		const size_t count = injected_count.load(std::memory_order_relaxed);
+		if (count > 0) {
+			TaskWrapper* task = injected[injected_head];
+			injected_head = (injected_head + 1) % injected.size();
+			injected_count.store(count - 1, std::memory_order_relaxed);
+			return task;
+		}
+	}
+
+	for (size_t i = 1; i < queues.size(); ++i) {
+		if (TaskWrapper* task = queues[(index + i) % queues.size()]->Steal()) {
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+	t_Pool = this;
+	t_WorkerIndex = index;
+
+	int idle = 0;
+	while (true) {
+		if (TaskWrapper* task = FindTask(index)) {
+			pending.fetch_sub(1, std::memory_order_relaxed);
+			(*task)();
+			Release(task);
+			idle = 0;
+			continue;
+		}
+
+		// Tasks still queued when the pool stops are run first
+		if (stop.load() && pending.load() == 0) {
+			return;
+		}
+
+		if (++idle < IDLE_ROUNDS) {
+			std::this_thread::yield();
+			continue;
+		}
+		idle = 0;
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleeping.fetch_add(1);
+		condition.wait(lock, [this] {
+			return stop.load() || pending.load() > 0;
+		});
+		sleeping.fetch_sub(1);
+	}
+}